@@ -0,0 +1,331 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: BatchRunner.cpp
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+// Command-line batch runner. It runs the batch processing of the
+// BatchProcessor dialog without any window, so that it can be used on
+// machines without a display. Only a QCoreApplication is created.
+//
+// Usage:
+//     cvutil-batch --plugin <name> --input <dir> --output <dir>
+//                  [--config <file>] [--parallel <n>] [--threads <n>]
+//                  [--plugins <path>] [--restart]
+//
+// The config file is an INI file with the values of the parameters of
+// the plugin in the [parameters] section, keyed by the parameter names
+// (IParameterInfo::getName()). For example,
+//
+//     [parameters]
+//     threshold = 200
+//     invert = true
+//     diameterrange = 5, 40
+//     method = 1
+//
+// Boolean parameters take true/false (or 1/0), span parameters take the
+// lower and upper limits, and item parameters take the index or the
+// text of the item. The parameters that are not listed keep their
+// default values.
+//
+// A batch that is interrupted, for example by the preemption of a
+// cluster job, resumes from the journal it left in the output directory
+// when the same command is run again. If the journal does not match the
+// plugin or the output tables, the runner exits with an error instead of
+// overwriting them. Use --restart to start over.
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QSettings>
+
+#include <PluginInterfaces.h>
+#include <PluginManager.h>
+
+#include "cvutil_core.h"
+#include "MainWindow/FeatureExtractorThread.h"
+#include "MainWindow/helper_functions.h"
+
+#include <iostream>
+
+using namespace std;
+
+// Sets the value of the parameter p from its text in the config file.
+// Returns false if the text is not a valid value of the parameter.
+static bool setparameter(IParameterInfo *p, QString value)
+{
+    bool ok = false, ok2 = false;
+    value = value.trimmed();
+
+    switch (p->getParameterType())
+    {
+    case ParameterType::Boolean:
+    {
+        QString v = value.toLower();
+
+        if (v == "true" || v == "1" || v == "false" || v == "0")
+        {
+            dynamic_cast<BooleanParameter *>(p)->setValue(v == "true" || v == "1");
+            ok = true;
+        }
+
+        break;
+    }
+    case ParameterType::Integer:
+    case ParameterType::IntegerRange:
+    {
+        IntegerParameter *ip = dynamic_cast<IntegerParameter *>(p);
+        int v = value.toInt(&ok);
+
+        ok = ok && v >= ip->getMinValue() && v <= ip->getMaxValue();
+
+        if (ok)
+            ip->setValue(v);
+
+        break;
+    }
+    case ParameterType::Float:
+    case ParameterType::FloatRange:
+    {
+        FloatParameter *fp = dynamic_cast<FloatParameter *>(p);
+        float v = value.toFloat(&ok);
+
+        ok = ok && v >= fp->getMinValue() && v <= fp->getMaxValue();
+
+        if (ok)
+            fp->setValue(v);
+
+        break;
+    }
+    case ParameterType::IntegerSpan:
+    {
+        IntegerSpanParameter *sp = dynamic_cast<IntegerSpanParameter *>(p);
+        QStringList limits = value.split(',');
+
+        if (limits.size() != 2)
+            break;
+
+        int lo = limits[0].trimmed().toInt(&ok);
+        int hi = limits[1].trimmed().toInt(&ok2);
+
+        ok = ok && ok2 && lo <= hi && lo >= sp->getMinValue() && hi <= sp->getMaxValue();
+
+        if (!ok)
+            break;
+
+        // The lower limit can not exceed the current upper limit and
+        // vice versa, so the limits are set in the order that keeps
+        // them valid.
+        if (lo <= sp->alt_getValue())
+        {
+            sp->setValue(lo);
+            sp->alt_setValue(hi);
+        }
+        else
+        {
+            sp->alt_setValue(hi);
+            sp->setValue(lo);
+        }
+
+        break;
+    }
+    case ParameterType::Items:
+    {
+        ItemsParameter *itp = dynamic_cast<ItemsParameter *>(p);
+        auto items = itp->getItems();
+        int v = value.toInt(&ok);
+
+        if (!ok)
+            for (v = 0; v < static_cast<int>(items.size()); v++)
+                if (QString::fromStdString(items[v]) == value)
+                    break;
+
+        ok = v >= 0 && v < static_cast<int>(items.size());
+
+        if (ok)
+            itp->setValue(v);
+
+        break;
+    }
+    default:
+        break;
+    }
+
+    return ok;
+}
+
+static bool loadconfig(IPlugin *plugin, QString filename)
+{
+    if (!QFileInfo(filename).isFile())
+    {
+        cerr << "Cannot open the config file " << filename.toStdString() << "." << endl;
+        return false;
+    }
+
+    QSettings config(filename, QSettings::IniFormat);
+    auto params = plugin->getParameters();
+    bool result = true;
+
+    config.beginGroup("parameters");
+
+    for (auto& key : config.childKeys())
+    {
+        // Values with commas are read as lists.
+        QVariant var = config.value(key);
+        QString value = (var.typeId() == QMetaType::QStringList) ? var.toStringList().join(",") : var.toString();
+        IParameterInfo *param = nullptr;
+
+        for (auto p : params)
+            if (QString::fromStdString(p->getName()) == key)
+                param = p;
+
+        if (param == nullptr)
+        {
+            cerr << "Unknown parameter " << key.toStdString() << "." << endl;
+            result = false;
+        }
+        else if (!setparameter(param, value))
+        {
+            cerr << "Invalid value " << value.toStdString() << " for the parameter " << key.toStdString() << "." << endl;
+            result = false;
+        }
+    }
+
+    config.endGroup();
+
+    return result;
+}
+
+static QString dirpath(QString path)
+{
+    path = QDir(path).absolutePath();
+
+    if (!path.endsWith('/'))
+        path += "/";
+
+    return path;
+}
+
+int main(int argc, char *argv[])
+{
+    cvutil::init(argc, argv, true, false);
+
+    QCoreApplication::setApplicationName("cvutil-batch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs a plugin on all the images of a directory.");
+    parser.addHelpOption();
+
+    QCommandLineOption pluginopt("plugin", "Name of the plugin.", "name");
+    QCommandLineOption inputopt("input", "Directory containing the images.", "dir");
+    QCommandLineOption outputopt("output", "Directory for the outputs.", "dir");
+    QCommandLineOption configopt("config", "INI file with the parameter values.", "file");
+    QCommandLineOption parallelopt("parallel", "Number of images analyzed at a time.", "n", "1");
+    QCommandLineOption threadsopt("threads", "Number of workers of the cvutil kernels.", "n", "0");
+    QCommandLineOption pluginsopt("plugins", "Plugin file or directory of plugins.", "path");
+    QCommandLineOption restartopt("restart", "Start over instead of resuming the batch journaled in the output directory.");
+
+    parser.addOptions({ pluginopt, inputopt, outputopt, configopt, parallelopt, threadsopt, pluginsopt, restartopt });
+    parser.process(*QCoreApplication::instance());
+
+    if (!parser.isSet(pluginopt) || !parser.isSet(inputopt) || !parser.isSet(outputopt))
+    {
+        cerr << "The options --plugin, --input and --output are required." << endl;
+        return 1;
+    }
+
+    QString imgpath = dirpath(parser.value(inputopt));
+    QString savpath = dirpath(parser.value(outputopt));
+
+    if (!QFileInfo(imgpath).isDir())
+    {
+        cerr << "Invalid image location " << imgpath.toStdString() << "." << endl;
+        return 1;
+    }
+
+    if (!QDir().mkpath(savpath))
+    {
+        cerr << "Invalid output location " << savpath.toStdString() << "." << endl;
+        return 1;
+    }
+
+    if (parser.isSet(threadsopt))
+        cvutil::setNumWorkers(parser.value(threadsopt).toInt(), false);
+
+    PluginManager *pm = PluginManager::GetInstance();
+    pm->Load(parser.value(pluginsopt).toStdString());
+
+    IPlugin *plugin = pm->GetPluginByName(parser.value(pluginopt).toStdString());
+
+    if (plugin == nullptr)
+    {
+        cerr << "Plugin " << parser.value(pluginopt).toStdString() << " not found." << endl;
+        return 1;
+    }
+
+    if (parser.isSet(configopt) && !loadconfig(plugin, parser.value(configopt)))
+        return 1;
+
+    QStringList filelist = getimagefiles(imgpath);
+
+    if (filelist.size() == 0)
+    {
+        cerr << "No image found." << endl;
+        return 1;
+    }
+
+    plugin->setBatchMode(true);
+    plugin->saveMetadata(imgpath, savpath);
+
+    FeatureExtractorThread workthread;
+    workthread.setMainPlugin(plugin);
+    workthread.setfilelist(filelist);
+    workthread.setsavelocation(savpath);
+    workthread.setInstances(parser.value(parallelopt).toInt());
+    workthread.setResume(!parser.isSet(restartopt));
+
+    // The progress is printed by the main thread, as the signal may be
+    // emitted by several threads.
+    QObject::connect(&workthread, &FeatureExtractorThread::ReportProgress, QCoreApplication::instance(), [&](QString filename, int fileno)
+    {
+        cout << "[" << (fileno + 1) << "/" << filelist.size() << "] " << QFileInfo(filename).fileName().toStdString() << endl;
+    });
+
+    QObject::connect(&workthread, &FeatureExtractorThread::finished, QCoreApplication::instance(), &QCoreApplication::quit);
+
+    QObject::connect(&workthread, &FeatureExtractorThread::Failed, QCoreApplication::instance(), [](QString message)
+    {
+        cerr << message.toStdString() << endl
+             << "Use --restart to start over, or choose another output directory." << endl;
+    });
+
+    workthread.start();
+    QCoreApplication::exec();
+    workthread.wait();
+
+    plugin->setBatchMode(false);
+
+    return workthread.isfinished() ? 0 : 1;
+}
@@ -33,10 +33,27 @@ using namespace std;
 
 void PluginManager::Load(string path)
 {
-    pluginsDir = QDir(QApplication::instance()->applicationDirPath());
-    pluginsDir.cd("plugins");
+    QStringList files;
+    QFileInfo pathinfo(QString::fromStdString(path));
 
-    for (QString &fileName : pluginsDir.entryList(QDir::Files))
+    if (path.empty())
+    {
+        pluginsDir = QDir(QCoreApplication::applicationDirPath());
+        pluginsDir.cd("plugins");
+        files = pluginsDir.entryList(QDir::Files);
+    }
+    else if (pathinfo.isDir())
+    {
+        pluginsDir = QDir(pathinfo.absoluteFilePath());
+        files = pluginsDir.entryList(QDir::Files);
+    }
+    else
+    {
+        pluginsDir = pathinfo.absoluteDir();
+        files.push_back(pathinfo.fileName());
+    }
+
+    for (QString &fileName : files)
     {
         QPluginLoader loader(pluginsDir.absoluteFilePath(fileName));
         QObject *plugin = loader.instance();
@@ -38,6 +38,8 @@ along with cvutil; see the file COPYING.  If not, see
 #include <QtCharts/QtCharts>
 #pragma warning(pop)
 
+#include <atomic>
+
 #ifdef _WIN64
 #if (!defined PLUGINAPI)
 #if (defined PLUGINMANAGER_SOURCE)
@@ -233,6 +235,20 @@ public:
 
 Q_DECLARE_METATYPE(ItemsParameter*);
 
+// Cooperative cancellation of the analysis of an image. The host sets the
+// token when the batch processing is paused or stopped, and a plugin may
+// poll it between the stages of execute() to return early. The outputs
+// of an image whose analysis was cancelled are not saved.
+class CancellationToken
+{
+    std::atomic<bool> cancelled{ false };
+
+public:
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    void reset() { cancelled.store(false, std::memory_order_relaxed); }
+    bool iscancelled() const { return cancelled.load(std::memory_order_relaxed); }
+};
+
 class IPlugin// : public QObject
 {
     //Q_OBJECT;
@@ -303,7 +319,9 @@ public:
 
     // Enables the user to abort an analysis that is taking longer time.
     // It works only if the plugin supports multiple progress steps and 
-    // updates progress to the main window using updateProgress().
+    // updates progress to the main window using updateProgress(). The 
+    // batch processing calls it from another thread when it is paused
+    // or stopped.
     virtual void abort() = 0;
 signals:
     // To be used as signal to the main application to update the image shown.
@@ -314,9 +332,56 @@ signals:
     virtual void updateProgress(QString status) = 0;
 };
 
+// Optional interface of the plugins that can be cloned. It is kept apart
+// from IPlugin, so that the layout of IPlugin, which is shared with the
+// plugins built against earlier versions of this header, is unchanged.
+// A plugin implements it by deriving from both the interfaces and listing
+// both of them in Q_INTERFACES.
+class IClonablePlugin
+{
+public:
+    virtual ~IClonablePlugin() {}
+
+    // Creates a new instance of the plugin with the same parameter values,
+    // which is used by the batch processing to analyze several images at 
+    // a time. Each instance is used by one thread at a time, so the 
+    // instances must not share any state that is modified by execute() or 
+    // saveOutput(). The caller owns the returned instance. A plugin that 
+    // cannot be cloned at the moment may return nullptr, in which case it
+    // is run with a single instance.
+    virtual IPlugin *clone() = 0;
+};
+
+// Optional interface of the plugins that poll a cancellation token in
+// execute(). Like IClonablePlugin, it is kept apart from IPlugin.
+class ICancellablePlugin
+{
+public:
+    virtual ~ICancellablePlugin() {}
+
+    // Sets the token to be polled by execute(), or nullptr when the 
+    // plugin is no longer used by the batch processing. The token is
+    // owned by the host. When it is set, execute() may return early.
+    virtual void setCancellationToken(const CancellationToken *token) = 0;
+};
+
 QT_BEGIN_NAMESPACE
 #define IPlugin_iid "org.plugin.ImageProcessing.Segmentation.IPlugin"
 Q_DECLARE_INTERFACE(IPlugin, IPlugin_iid)
+
+#define IClonablePlugin_iid "org.plugin.ImageProcessing.IClonablePlugin/1.0"
+Q_DECLARE_INTERFACE(IClonablePlugin, IClonablePlugin_iid)
+
+#define ICancellablePlugin_iid "org.plugin.ImageProcessing.ICancellablePlugin/1.0"
+Q_DECLARE_INTERFACE(ICancellablePlugin, ICancellablePlugin_iid)
 QT_END_NAMESPACE
 
+// Returns the optional interface T of a plugin, or nullptr if the plugin
+// does not implement it.
+template <class T>
+T *plugin_cast(IPlugin *plugin)
+{
+    return qobject_cast<T *>(dynamic_cast<QObject *>(plugin));
+}
+
 #endif
@@ -77,9 +77,6 @@ public:
         return &instance;
     }
 
-    // FIXME - The following is the correct 
-    // functionality.
-
     // If the path is full file path, then only 
     // the plugin is loaded. If the the path is 
     // a directory, all the plugins in the path 
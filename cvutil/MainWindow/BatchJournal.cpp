@@ -0,0 +1,251 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: BatchJournal.cpp
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#include "BatchJournal.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDebug>
+#include <QtCore/QFileInfo>
+
+using namespace std;
+
+static const char *journalmagic = "cvutil batch journal 1";
+
+QString BatchJournal::path(QString saveloc)
+{
+    return saveloc + "cvutil_batch.journal";
+}
+
+bool BatchJournal::exists(QString saveloc)
+{
+    return QFileInfo::exists(path(saveloc));
+}
+
+vector<qint64> BatchJournal::tablesizes()
+{
+    vector<qint64> result;
+
+    for (auto& t : tables)
+        result.push_back(QFileInfo(saveloc + t).size());
+
+    return result;
+}
+
+bool BatchJournal::resume(QString _saveloc, QString plugin)
+{
+    close();
+    saveloc = _saveloc;
+    tables.clear();
+    sizes.clear();
+    done.clear();
+
+    QFile in(path(saveloc));
+
+    if (!in.open(QFile::ReadOnly))
+        return false;
+
+    QByteArray content = in.readAll();
+    in.close();
+
+    // The lines are written whole, so only the last line can be cut
+    // short by the interruption of the batch. A line is complete once
+    // its newline is written, and the part after the last newline is
+    // dropped.
+    QList<QByteArray> lines = content.split('\n');
+    qint64 keep = content.size() - lines.back().size();
+    lines.pop_back();
+
+    if (lines.empty() || lines[0] != journalmagic)
+        return false;
+
+    bool valid = true, named = false;
+    vector<QFile *> tfiles;
+
+    for (int i = 1; i < lines.size() && valid; i++)
+    {
+        QStringList fields = QString::fromUtf8(lines[i]).split('\t');
+
+        if (fields[0] == "plugin")
+        {
+            named = (fields.size() == 2 && fields[1] == plugin);
+            valid = named;
+        }
+        else if (fields[0] == "table" && fields.size() == 3)
+        {
+            tables.push_back(fields[1]);
+            sizes.push_back(fields[2].toLongLong());
+        }
+        else if (fields[0] == "done" && fields.size() == 3 + tables.size())
+        {
+            // The rows of every entry are checked against its hash, so
+            // that tables overwritten after the batch are not appended
+            // to.
+            if (tfiles.empty())
+            {
+                for (auto& t : tables)
+                {
+                    tfiles.push_back(new QFile(saveloc + t));
+                    tfiles.back()->open(QFile::ReadOnly);
+                }
+            }
+
+            QCryptographicHash hash(QCryptographicHash::Sha1);
+
+            for (int k = 0; k < tables.size() && valid; k++)
+            {
+                qint64 size = fields[3 + k].toLongLong();
+
+                if (size < sizes[k] || size > tfiles[k]->size())
+                    valid = false;
+                else
+                {
+                    tfiles[k]->seek(sizes[k]);
+                    hash.addData(tfiles[k]->read(size - sizes[k]));
+                    sizes[k] = size;
+                }
+            }
+
+            valid = valid && (hash.result().toHex() == fields[2].toUtf8());
+
+            if (!valid)
+                qWarning() << "The tables in" << saveloc << "do not match the batch journal at" << fields[1];
+            else
+                done.insert(fields[1]);
+        }
+        else
+            valid = false;
+    }
+
+    for (auto f : tfiles)
+        delete f;
+
+    valid = valid && named;
+
+    // The rows written after the last entry are dropped.
+    for (int k = 0; k < tables.size() && valid; k++)
+        valid = QFile::resize(saveloc + tables[k], sizes[k]);
+
+    if (valid)
+    {
+        file.setFileName(path(saveloc));
+        valid = file.resize(keep) && file.open(QFile::Append);
+    }
+
+    if (!valid)
+    {
+        tables.clear();
+        sizes.clear();
+        done.clear();
+    }
+
+    return valid;
+}
+
+bool BatchJournal::create(QString _saveloc, QString plugin, QStringList _tables)
+{
+    close();
+    saveloc = _saveloc;
+    tables = _tables;
+    sizes = tablesizes();
+    done.clear();
+
+    file.setFileName(path(saveloc));
+
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        qCritical() << "Cannot write the batch journal" << path(saveloc);
+        return false;
+    }
+
+    QString header = QString(journalmagic) + "\nplugin\t" + plugin + "\n";
+
+    for (int k = 0; k < tables.size(); k++)
+        header += "table\t" + tables[k] + "\t" + QString::number(sizes[k]) + "\n";
+
+    file.write(header.toUtf8());
+    file.flush();
+
+    return true;
+}
+
+BatchJournal::Entry BatchJournal::collect(QString filename)
+{
+    Entry e;
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    e.filename = filename;
+    e.sizes = tablesizes();
+
+    for (int k = 0; k < tables.size(); k++)
+    {
+        if (e.sizes[k] > sizes[k])
+        {
+            QFile table(saveloc + tables[k]);
+
+            if (table.open(QFile::ReadOnly))
+            {
+                table.seek(sizes[k]);
+                hash.addData(table.read(e.sizes[k] - sizes[k]));
+            }
+        }
+    }
+
+    e.hash = hash.result().toHex();
+    sizes = e.sizes;
+
+    return e;
+}
+
+void BatchJournal::write(const Entry& e, bool saved)
+{
+    if (!file.isOpen())
+        return;
+
+    if (!saved)
+    {
+        qWarning() << "The outputs of" << e.filename << "could not be saved. The batch journal"
+            << "takes no more entries, so this file and the files after it are analyzed"
+            << "again when the batch is resumed.";
+        close();
+        return;
+    }
+
+    QString line = "done\t" + e.filename + "\t" + QString::fromUtf8(e.hash);
+
+    for (auto s : e.sizes)
+        line += "\t" + QString::number(s);
+
+    file.write((line + "\n").toUtf8());
+    file.flush();
+}
+
+void BatchJournal::close()
+{
+    if (file.isOpen())
+        file.close();
+}
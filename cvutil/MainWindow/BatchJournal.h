@@ -0,0 +1,105 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: BatchJournal.h
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef BATCHJOURNAL_H
+#define BATCHJOURNAL_H
+
+#include <QtCore/QFile>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+
+#include <vector>
+
+// Journal of a batch run, kept in the save location so that a batch that
+// was stopped, or whose process was killed, can resume where it left
+// off. The journal names the plugin and its tables (the files written by
+// writeHeader()) with their sizes after the header. For each file whose
+// outputs are saved, an entry holds the SHA-1 hash of the rows the file
+// appended to the tables and the sizes of the tables after these rows.
+// The fields of a line are separated by tabs.
+//
+//      cvutil batch journal 1
+//      plugin  <plugin name>
+//      table   <path relative to the save location>  <header size>
+//      done    <file name>  <hash>  <size of each table>
+//
+// On resume, the rows of the tables are checked against the hashes, and
+// the tables are cut to the sizes of the last entry, which drops the rows
+// of the files that were being processed when the batch was interrupted.
+class BatchJournal
+{
+    QString saveloc;
+    QStringList tables;
+    std::vector<qint64> sizes;  // Sizes of the tables after the rows collected last
+    QSet<QString> done;
+    QFile file;
+
+    std::vector<qint64> tablesizes();
+
+public:
+    struct Entry
+    {
+        QString filename;
+        QByteArray hash;
+        std::vector<qint64> sizes;
+    };
+
+    static QString path(QString saveloc);
+    static bool exists(QString saveloc);
+
+    // Reads the journal of the save location and opens it for new
+    // entries. Returns false if there is no journal, it was written for
+    // another plugin, or the tables do not match it.
+    bool resume(QString saveloc, QString plugin);
+
+    // Starts a new journal with the given tables, whose present sizes
+    // are taken as their header sizes.
+    bool create(QString saveloc, QString plugin, QStringList tables);
+
+    // Returns true if the journal has an entry for the file name.
+    bool isdone(QString filename) const { return done.contains(filename); }
+
+    // Reads the rows appended to the tables since the previous call,
+    // for the entry of the file. The entry is written separately, once
+    // the other outputs of the file are saved as well.
+    Entry collect(QString filename);
+
+    // Appends the entry to the journal. The entries must be written in
+    // the order they are collected. If saved is false, the outputs of the
+    // file could not be saved: the entry is dropped and the journal takes
+    // no more entries, so that the file and the files after it (whose
+    // entries would not validate without it) are analyzed again when the
+    // batch is resumed.
+    void write(const Entry& e, bool saved = true);
+
+    void close();
+};
+
+#endif
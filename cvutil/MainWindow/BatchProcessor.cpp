@@ -69,8 +69,20 @@ BatchProcessor::BatchProcessor(IPlugin *plugin, QString inputfileloc)
     pause = new QPushButton("Pause");
     pause->setDisabled(true);
     quit = new QPushButton("Quit");
+
+    // Number of images analyzed at a time, each by its own instance of
+    // the plugin.
+    instlabel = new QLabel("Parallel images : ");
+    instances = new QSpinBox();
+    instances->setRange(1, max(1, QThread::idealThreadCount()));
+    instances->setValue(1);
+    instances->setToolTip("Number of images analyzed at a time. Used only if the plugin supports multiple instances.");
+
     QHBoxLayout *hlay = new QHBoxLayout();
     hlay->setAlignment(Qt::AlignRight);
+    hlay->addWidget(instlabel, 0, Qt::AlignLeft);
+    hlay->addWidget(instances, 0, Qt::AlignLeft);
+    hlay->addStretch();
     hlay->addWidget(start, 0, Qt::AlignRight);
     hlay->addWidget(pause, 0, Qt::AlignRight);
     hlay->addWidget(quit, 0, Qt::AlignRight);
@@ -113,6 +125,7 @@ void BatchProcessor::connectSignalstoSlots()
 
     connect(workthread, &FeatureExtractorThread::ReportProgress, this, &BatchProcessor::UpdateProgress);
     connect(workthread, &FeatureExtractorThread::finished, this, &BatchProcessor::workfinished);
+    connect(workthread, &FeatureExtractorThread::Failed, this, &BatchProcessor::workfailed);
 }
 
 void BatchProcessor::closeEvent(QCloseEvent * ev)
@@ -155,15 +168,7 @@ void BatchProcessor::keyPressEvent(QKeyEvent *ev)
 
 void BatchProcessor::getfilelist(QString imgpath)
 {
-    filelist.clear();
-
-    QDir dir(imgpath);
-    QStringList images = dir.entryList(QStringList() 
-        << "*.png" << "*.PNG" << "*.jpg" << "*.JPG" << "*.bmp" << "*.BMP" << "*.jpeg" << "*.JPEG" << "*.jpe" << "*.JPE"
-        << "*.dib" << "*.DIB" << "*.jp2" << "*.JP2" << "*.tiff" << "*.TIFF" << "*.tif" << "*.TIF", QDir::Files);
-    natsort(images);
-    for (auto image : images)
-        filelist.push_back(imgpath + image);
+    filelist = getimagefiles(imgpath);
 }
 
 void BatchProcessor::UpdateProgress(QString filename, int fileno)
@@ -188,6 +193,7 @@ void BatchProcessor::workfinished()
         imgsavGroupBox->setEnabled(true);
         if (imgoptGroupBox != nullptr)
             imgoptGroupBox->setEnabled(true);
+        instances->setEnabled(true);
         pause->setText("Pause");
         pause->setDisabled(true);
 
@@ -207,6 +213,20 @@ void BatchProcessor::workfinished()
     }
 }
 
+// The outputs are left as they are, so that the user can choose to start
+// over or to save to another location.
+void BatchProcessor::workfailed(QString message)
+{
+    if (mode == CurrentMode::Stopped)
+        return;
+
+    realstop();
+    mode = CurrentMode::Stopped;
+
+    QMessageBox::critical(nullptr, "RhizoVision Analyzer", message +
+        " To start over, answer No when asked to resume the batch, or choose another output location.");
+}
+
 bool BatchProcessor::realstart()
 {
     QString imgpath = imgloc;
@@ -233,6 +253,22 @@ bool BatchProcessor::realstart()
         sbar->showMessage("No image found.", statusbartimeout);
         return false;
     }
+
+    // The output location holds the journal of a batch that was stopped
+    // or interrupted before it completed the files.
+    bool resume = false;
+
+    if (BatchJournal::exists(savloc))
+    {
+        auto answer = QMessageBox::question(nullptr, "RhizoVision Analyzer",
+            "The output location has the journal of an earlier batch. Do you wish to resume it, skipping the files it completed?",
+            QMessageBox::StandardButton::Yes | QMessageBox::StandardButton::No | QMessageBox::StandardButton::Cancel);
+
+        if (answer == QMessageBox::StandardButton::Cancel)
+            return false;
+
+        resume = (answer == QMessageBox::StandardButton::Yes);
+    }
     
     IPlugin *pl;
 
@@ -253,6 +289,7 @@ bool BatchProcessor::realstart()
     imgsavGroupBox->setDisabled(true);
     if (imgoptGroupBox != nullptr)
         imgoptGroupBox->setDisabled(true);
+    instances->setDisabled(true);
     progress->setMaximum(static_cast<int>(filelist.size()));
 
     //sort(filelist.begin(), filelist.end(), namecompare);
@@ -262,6 +299,8 @@ bool BatchProcessor::realstart()
 
     workthread->setfilelist(filelist);
     workthread->setPluginIndex(curridx);
+    workthread->setInstances(instances->value());
+    workthread->setResume(resume);
     pl->saveMetadata(imgpath, savpath);
 
     // Save the settings in a metadata file in the output directory.
@@ -288,16 +327,14 @@ void BatchProcessor::realstop()
     imgsavGroupBox->setEnabled(true);
     if (imgoptGroupBox != nullptr)
         imgoptGroupBox->setEnabled(true);
+    instances->setEnabled(true);
     pause->setText("Pause");
     pause->setDisabled(true);
     
-    workthread->requestInterruption();
-    
-    // Wait till thread stopped
-    while (!workthread->isFinished())
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    // Wait till thread stopped. The files being analyzed are cancelled,
+    // so the thread finishes as soon as the plugin returns.
+    workthread->cancel();
+    workthread->wait();
 
     // Stop the timer
     elapsed = 0;
@@ -318,14 +355,10 @@ void BatchProcessor::realpause()
     if (imgoptGroupBox != nullptr)
         imgoptGroupBox->setEnabled(true);
     
-    workthread->requestInterruption();
-    
     // Proceed to event handling only 
     // after thread is stopped.
-    while (!workthread->isFinished())
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    workthread->cancel();
+    workthread->wait();
 
     // Timer updating...
     // Pause is similar to stopping except that
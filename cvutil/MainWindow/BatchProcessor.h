@@ -51,6 +51,7 @@ public:
 public slots:
     void UpdateProgress(QString filename, int fileno);
     void workfinished();
+    void workfailed(QString message);
 
 protected:
     void timerEvent(QTimerEvent * ev);
@@ -97,6 +98,8 @@ private:
     QProgressBar *progress;
 
     QPushButton *start, *pause, *quit;
+    QLabel *instlabel;
+    QSpinBox *instances;
     QStatusBar *sbar;
 
     // Timer functionality
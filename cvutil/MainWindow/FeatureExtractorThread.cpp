@@ -27,12 +27,17 @@ along with cvutil; see the file COPYING.  If not, see
 */
 
 #include "FeatureExtractorThread.h"
+#include "ImagePrefetcher.h"
 
 //#include <ImageProcessor.h>
 #include <PluginManager.h>
 
 #include "../cvutil_core.h"
 
+#include <map>
+#include <mutex>
+#include <thread>
+
 using namespace std;
 using namespace cv;
 
@@ -62,6 +67,29 @@ void FeatureExtractorThread::setMainPlugin(IPlugin *p)
     mainplugin = p;
 }
 
+void FeatureExtractorThread::setPipeline(int decoders, int writers, int size)
+{
+    ndecoders = max(1, decoders);
+    nwriters = max(1, writers);
+    queuesize = max(1, size);
+}
+
+void FeatureExtractorThread::setInstances(int n)
+{
+    ninstances = max(1, n);
+}
+
+void FeatureExtractorThread::cancel()
+{
+    requestInterruption();
+    token.cancel();
+
+    lock_guard<mutex> lock(instmtx);
+
+    for (auto p : active)
+        p->abort();
+}
+
 // We wanted to implement our own "finished"
 // functionality than using the isFinished()
 // because the thread we implemented is 
@@ -73,10 +101,191 @@ bool FeatureExtractorThread::isfinished()
     return workfinished;
 }
 
+namespace
+{
+    // Rows appended to the tables of a plugin for one file, as pairs
+    // of the table path relative to the save location and the rows.
+    typedef vector<pair<QString, QByteArray>> FileRows;
+
+    // Outputs of one file of a parallel batch, held until the file is
+    // merged. images are the paths of the output images relative to the
+    // directory held, and saved is false if any output was lost.
+    struct FileOutputs
+    {
+        FileRows rows;
+        QString held;
+        QStringList images;
+        bool saved = true;
+    };
+
+    // Save location of one plugin instance of a parallel batch. The
+    // instance saves the outputs of each file into its own staging
+    // directory. The new files (the output images) are then moved to a
+    // directory held for the file, while the rows appended to the tables
+    // (the files written by writeHeader() and the CSV files) are cut
+    // from the staged tables. Both are moved to the save location when
+    // the file is merged, in file order.
+    class StagingArea
+    {
+        QString stageloc;
+        map<QString, qint64> tables;    // Header size of each table
+
+        QStringList files()
+        {
+            QStringList result;
+            QDir stage(stageloc);
+            QDirIterator it(stageloc, QDir::Files, QDirIterator::Subdirectories);
+
+            while (it.hasNext())
+                result.push_back(stage.relativeFilePath(it.next()));
+
+            return result;
+        }
+
+    public:
+        StagingArea(QString _stageloc) : stageloc(_stageloc)
+        {
+            QDir(stageloc).removeRecursively();
+            QDir().mkpath(stageloc);
+        }
+
+        ~StagingArea()
+        {
+            QDir(stageloc).removeRecursively();
+        }
+
+        QString location() { return stageloc; }
+
+        // Records the files written by writeHeader() as tables.
+        void marktables()
+        {
+            for (auto& rel : files())
+                tables[rel] = QFileInfo(stageloc + rel).size();
+        }
+
+        // Cuts the new rows from the staged tables and moves the other
+        // new files to the directory held.
+        FileOutputs collect(QString held)
+        {
+            FileOutputs out;
+            out.held = held;
+
+            for (auto& rel : files())
+            {
+                QString path = stageloc + rel;
+                auto t = tables.find(rel);
+
+                if (t == tables.end() && rel.endsWith(".csv", Qt::CaseInsensitive))
+                    t = tables.emplace(rel, 0).first;
+
+                if (t != tables.end())
+                {
+                    QFile file(path);
+
+                    if (!file.open(QFile::ReadWrite))
+                    {
+                        qCritical() << "Cannot read the staged table" << path;
+                        continue;
+                    }
+
+                    file.seek(t->second);
+                    QByteArray bytes = file.readAll();
+                    file.resize(t->second);
+                    file.close();
+
+                    if (!bytes.isEmpty())
+                        out.rows.emplace_back(rel, bytes);
+                }
+                else
+                {
+                    QString dest = held + rel;
+
+                    QDir().mkpath(QFileInfo(dest).absolutePath());
+
+                    if (QFile::rename(path, dest))
+                        out.images.push_back(rel);
+                    else
+                    {
+                        // The file is not left in the staging directory,
+                        // where it would be taken for an output of the
+                        // next file.
+                        qCritical() << "Cannot move" << path << "out of the staging directory.";
+                        QFile::remove(path);
+                        out.saved = false;
+                    }
+                }
+            }
+
+            return out;
+        }
+    };
+
+    // Sizes and modification times of the files in a directory.
+    map<QString, pair<qint64, QDateTime>> listfiles(QString dir)
+    {
+        map<QString, pair<qint64, QDateTime>> result;
+
+        for (auto& f : QDir(dir).entryInfoList(QDir::Files))
+            result[f.fileName()] = { f.size(), f.lastModified() };
+
+        return result;
+    }
+
+    // Returns false if any of the rows cannot be written.
+    bool appendrows(QString saveloc, const FileRows& rows)
+    {
+        bool result = true;
+
+        for (auto& r : rows)
+        {
+            QFile file(saveloc + r.first);
+
+            if (file.open(QFile::Append) && file.write(r.second) == r.second.size())
+                continue;
+
+            qCritical() << "Cannot write to" << saveloc + r.first;
+            result = false;
+        }
+
+        return result;
+    }
+
+    // Moves the held images of a file to the save location and appends
+    // its rows to the tables. Returns false if any of the outputs of the
+    // file is not saved.
+    bool mergeoutputs(QString saveloc, const FileOutputs& out)
+    {
+        bool result = out.saved;
+
+        for (auto& rel : out.images)
+        {
+            QString dest = saveloc + rel;
+
+            QDir().mkpath(QFileInfo(dest).absolutePath());
+            QFile::remove(dest);
+
+            if (!QFile::rename(out.held + rel, dest))
+            {
+                qCritical() << "Cannot move" << out.held + rel << "to the output location.";
+                result = false;
+            }
+        }
+
+        QDir(out.held).removeRecursively();
+
+        return appendrows(saveloc, out.rows) && result;
+    }
+}
+
 void FeatureExtractorThread::run()
 {
     workfinished = false;
-    Mat inp, out;
+    token.reset();
+
+    // A cancel() made before the thread got here is not lost.
+    if (isInterruptionRequested())
+        token.cancel();
+
     IPlugin *plugin;
 
     if (!mainplugin)
@@ -88,31 +297,296 @@ void FeatureExtractorThread::run()
     else
         plugin = mainplugin;
 
-    if (plugin->getOutputType() == OutputType::ImageAndValues ||
-        plugin->getOutputType() == OutputType::ImagesAndValues)
-        plugin->writeHeader(saveloc);
+    // A paused batch continues with the journal it started with.
+    if (fileidx == 0 && !startjournal(plugin))
+        return;
+
+    vector<IPlugin *> instances = { plugin };
+    IClonablePlugin *clonable = plugin_cast<IClonablePlugin>(plugin);
+
+    for (int i = 1; i < ninstances; i++)
+    {
+        IPlugin *p = (clonable != nullptr) ? clonable->clone() : nullptr;
+
+        if (p == nullptr)
+        {
+            qInfo() << "The plugin does not support multiple instances. The files are processed one at a time.";
+            break;
+        }
+
+        p->setBatchMode(true);
+        instances.push_back(p);
+    }
+
+    for (auto p : instances)
+        if (auto c = plugin_cast<ICancellablePlugin>(p))
+            c->setCancellationToken(&token);
+
+    {
+        lock_guard<mutex> lock(instmtx);
+        active = instances;
+    }
+
+    if (instances.size() > 1)
+        runparallel(instances);
+    else
+        runpipeline(plugin);
+
+    {
+        lock_guard<mutex> lock(instmtx);
+        active.clear();
+    }
+
+    if (auto c = plugin_cast<ICancellablePlugin>(plugin))
+        c->setCancellationToken(nullptr);
+
+    for (size_t i = 1; i < instances.size(); i++)
+        delete instances[i];
+
+    workfinished = (fileidx >= filelist.size());
+
+    if (workfinished)
+        journal.close();
+}
+
+// Starts the journal of a new batch, or resumes the batch journaled in the
+// save location, in which case the header is not written again and the
+// journaled files are marked as completed. The tables of a new batch are
+// the files that writeHeader() creates or changes. If the journal to be
+// resumed does not match the plugin or the tables, the batch is not run,
+// as starting over would overwrite the tables.
+bool FeatureExtractorThread::startjournal(IPlugin *plugin)
+{
+    QString name = QString::fromStdString(plugin->getName());
+
+    if (resume && BatchJournal::exists(saveloc))
+    {
+        if (!journal.resume(saveloc, name))
+        {
+            QString message = "The batch journal in " + saveloc + " does not match the plugin "
+                "or the output tables, so the batch cannot be resumed.";
+
+            qCritical().noquote() << message;
+            emit Failed(message);
+            return false;
+        }
+
+        qInfo() << "Resuming the batch journaled in" << saveloc;
+    }
+    else
+    {
+        auto before = listfiles(saveloc);
+
+        if (plugin->getOutputType() == OutputType::ImageAndValues ||
+            plugin->getOutputType() == OutputType::ImagesAndValues)
+            plugin->writeHeader(saveloc);
+
+        QStringList tables;
+
+        for (auto& f : listfiles(saveloc))
+        {
+            auto b = before.find(f.first);
+
+            if (b == before.end() || b->second != f.second)
+                tables.push_back(f.first);
+        }
+
+        tables.removeAll(QFileInfo(BatchJournal::path(saveloc)).fileName());
+        journal.create(saveloc, name, tables);
+    }
+
+    completed.assign(filelist.size(), false);
+
+    for (int i = 0; i < filelist.size(); i++)
+        completed[i] = journal.isdone(QFileInfo(filelist[i]).fileName());
+
+    while (fileidx < filelist.size() && completed[fileidx])
+        fileidx++;
+
+    return true;
+}
+
+void FeatureExtractorThread::runpipeline(IPlugin *plugin)
+{
+    Mat inp;
+
+    // The files go through three stages. The decoders read and decode
+    // the next images while the plugin is processing the current one,
+    // the plugin runs on this thread in file order, so that the rows of
+    // the CSV file are in the order of the files, and the images saved
+    // with cvutil::imwrite() are encoded and written in the background.
+    // The completed files are left out of the decoding.
+    QStringList pending = filelist;
+
+    for (int i = 0; i < pending.size(); i++)
+        if (completed[i])
+            pending[i].clear();
+
+    ImagePrefetcher prefetcher(pending, fileidx, ndecoders, queuesize);
+    cvutil::setAsyncImageWrite(true, nwriters, queuesize);
 
     for (; fileidx < filelist.size(); fileidx++)
     {
         if (isInterruptionRequested())
-            return;
+            break;
+
+        //qDebug() << "DEBUG :: " << filelist[fileidx];
+        inp = prefetcher.take(fileidx);
+
+        if (completed[fileidx])
+            continue;
         
         emit ReportProgress(filelist[fileidx], fileidx);
 
         QFileInfo finfo(filelist[fileidx]);
 
-        //qDebug() << "DEBUG :: " << filelist[fileidx];
-        inp = cvutil::imread(filelist[fileidx]);
-        if (inp.channels() == 3)
-            cvtColor(inp, inp, COLOR_BGR2RGB);
-
         plugin->setImage(inp, finfo.fileName());
         plugin->execute();
+
+        // The analysis may be cut short, so the file is left to be
+        // analyzed again.
+        if (token.iscancelled())
+            break;
+
         plugin->saveOutput(saveloc, filelist[fileidx]);
 
+        // The rows are written by saveOutput(), while the images may
+        // still be queued, so the file is journaled once they are
+        // written, unless any of them failed.
+        BatchJournal::Entry entry = journal.collect(finfo.fileName());
+        cvutil::afterImageWrites([this, entry](bool written) { journal.write(entry, written); });
+        completed[fileidx] = true;
+
         //pfunc(&config, features);
     }
 
-    workfinished = true;
+    prefetcher.stop();
+
+    // The outputs of the processed files are written before the thread
+    // finishes, so a paused or stopped batch leaves no partial outputs.
+    cvutil::setAsyncImageWrite(false);
+}
+
+// Each instance takes the next file, decodes it, and runs the plugin on
+// it, so that up to instances.size() files are processed at a time. The
+// rows of the tables are merged in file order, so the output is the same
+// as that of runpipeline(). The output images are written synchronously,
+// as they are moved out of the staging directory after saveOutput(), and
+// reach the save location when the file is merged.
+void FeatureExtractorThread::runparallel(vector<IPlugin *> instances)
+{
+    IPlugin *plugin = instances[0];
+    bool hasheader = (plugin->getOutputType() == OutputType::ImageAndValues ||
+        plugin->getOutputType() == OutputType::ImagesAndValues);
+
+    mutex mtx;
+    int nexttake = fileidx, nextmerge = fileidx;
+    map<int, FileOutputs> pending;
+
+    // The outputs of the files that are not merged yet are held here.
+    QString holdloc = saveloc + ".batchheld/";
+    QDir(holdloc).removeRecursively();
+    QDir().mkpath(holdloc);
+
+    auto work = [&](int k)
+    {
+        IPlugin *pl = instances[k];
+        StagingArea stage(saveloc + QString(".batch%1/").arg(k));
+
+        if (hasheader)
+        {
+            pl->writeHeader(stage.location());
+            stage.marktables();
+        }
+
+        while (1)
+        {
+            int idx;
+
+            {
+                lock_guard<mutex> lock(mtx);
+
+                while (nexttake < filelist.size() && completed[nexttake])
+                    nexttake++;
+
+                if (isInterruptionRequested() || nexttake >= filelist.size())
+                    break;
+
+                idx = nexttake++;
+                emit ReportProgress(filelist[idx], idx);
+            }
+
+            QString filename = filelist[idx];
+            Mat inp = cvutil::imread(filename);
+
+            if (inp.channels() == 3)
+                cvtColor(inp, inp, COLOR_BGR2RGB);
+
+            pl->setImage(inp, QFileInfo(filename).fileName());
+            pl->execute();
+
+            // A cancelled file is not merged, so it and the files after
+            // it are analyzed again when the batch is resumed.
+            if (token.iscancelled())
+                break;
+
+            pl->saveOutput(stage.location(), filename);
+
+            // The images are written synchronously on this thread, so
+            // the status is known when afterImageWrites() returns.
+            bool saved = true;
+            cvutil::afterImageWrites([&saved](bool written) { saved = written; });
+
+            FileOutputs out = stage.collect(holdloc + QString::number(idx) + "/");
+            out.saved = out.saved && saved;
+
+            // The outputs of a file are merged once the outputs of all
+            // the files before it are merged, and the file is journaled
+            // with them.
+            lock_guard<mutex> lock(mtx);
+            pending[idx] = std::move(out);
+
+            while (nextmerge < filelist.size())
+            {
+                auto it = pending.find(nextmerge);
+
+                if (completed[nextmerge])
+                {
+                    nextmerge++;
+                    continue;
+                }
+
+                if (it == pending.end())
+                    break;
+
+                bool merged = mergeoutputs(saveloc, it->second);
+                journal.write(journal.collect(QFileInfo(filelist[nextmerge]).fileName()), merged);
+                completed[nextmerge] = true;
+                pending.erase(it);
+                nextmerge++;
+            }
+        }
+    };
+
+    vector<thread> threads;
+
+    for (int k = 1; k < static_cast<int>(instances.size()); k++)
+        threads.emplace_back(work, k);
+
+    work(0);
+
+    for (auto& t : threads)
+        t.join();
+
+    // The files are merged up to the first file that was cancelled, or
+    // was not taken as the batch was interrupted. The outputs held for
+    // the files after it are dropped, and these files are analyzed again
+    // when the batch is resumed.
+    QDir(holdloc).removeRecursively();
+
+    while (nextmerge < filelist.size() && completed[nextmerge])
+        nextmerge++;
+
+    fileidx = nextmerge;
 }
 
@@ -38,8 +38,11 @@ along with cvutil; see the file COPYING.  If not, see
 #include <QtCore/QThread>
 
 #include <filesystem>
+#include <mutex>
 #include <PluginInterfaces.h>
 
+#include "BatchJournal.h"
+
 class FeatureExtractorThread : public QThread
 {
     Q_OBJECT;
@@ -52,6 +55,30 @@ class FeatureExtractorThread : public QThread
     int plugin_index;
     bool workfinished = false;
     IPlugin *mainplugin = nullptr;
+
+    // Pipeline configuration
+    int ndecoders = 2;
+    int nwriters = 1;
+    int queuesize = 4;
+
+    // Number of plugin instances processing files at a time
+    int ninstances = 1;
+
+    // Journal of the completed files, and whether a new batch resumes
+    // the batch journaled in the save location.
+    BatchJournal journal;
+    std::vector<bool> completed;
+    bool resume = false;
+
+    // Cancellation of the files being analyzed, and the plugin instances
+    // analyzing them, which are aborted by cancel().
+    CancellationToken token;
+    std::mutex instmtx;
+    std::vector<IPlugin *> active;
+
+    bool startjournal(IPlugin *plugin);
+    void runpipeline(IPlugin *plugin);
+    void runparallel(std::vector<IPlugin *> instances);
 public:
     FeatureExtractorThread(QObject *parent = 0);
     void reset();
@@ -60,12 +87,39 @@ public:
     
     void setMainPlugin(IPlugin *p);
     void setPluginIndex(int idx) { plugin_index = idx; }
+
+    // Sets the number of threads decoding the next images, the number
+    // of threads writing the output images, and the number of images
+    // that each of these stages may hold ahead of the plugin.
+    void setPipeline(int decoders, int writers, int size);
+
+    // Sets the number of files processed at a time. If n > 1, the
+    // plugin is cloned with IClonablePlugin::clone() so that each file
+    // is processed by its own instance. The plugins that cannot be
+    // cloned process one file at a time.
+    void setInstances(int n);
+
+    // If on, a batch started with reset() skips the files recorded in
+    // the journal of the save location, and appends to its tables
+    // without writing their header again. If the journal does not
+    // match the plugin or the tables, Failed() is emitted and no file
+    // is processed. If off, the batch starts over with a new journal.
+    void setResume(bool on) { resume = on; }
+
+    // Asks the batch to stop for a pause or a stop. No more files are
+    // started, and the plugin instances are asked to abandon the files
+    // they are analyzing, which are analyzed again when the batch is
+    // resumed. Use wait() to block until the thread is finished.
+    void cancel();
     bool isfinished();
 
     void run();
 
 signals:
     void ReportProgress(QString filename, int fileno);
+
+    // The batch could not be run, with the reason in message.
+    void Failed(QString message);
 };
 
 
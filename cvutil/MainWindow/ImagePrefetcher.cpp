@@ -0,0 +1,114 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: ImagePrefetcher.cpp
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#include "ImagePrefetcher.h"
+
+#include "../cvutil_core.h"
+
+using namespace std;
+using namespace cv;
+
+ImagePrefetcher::ImagePrefetcher(QStringList flist, int first, int ndecoders, int _capacity)
+{
+    filelist = flist;
+    capacity = max(1, _capacity);
+    nextdecode = first;
+    nexttake = first;
+
+    for (int i = 0; i < max(1, ndecoders); i++)
+        decoders.emplace_back(&ImagePrefetcher::work, this);
+}
+
+ImagePrefetcher::~ImagePrefetcher()
+{
+    stop();
+}
+
+void ImagePrefetcher::stop()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+
+    cond.notify_all();
+
+    for (auto& t : decoders)
+        t.join();
+
+    decoders.clear();
+    decoded.clear();
+}
+
+Mat ImagePrefetcher::take(int idx)
+{
+    unique_lock<mutex> lock(mtx);
+
+    nexttake = idx;
+    cond.notify_all();
+    cond.wait(lock, [&] { return stopping || decoded.count(idx) > 0; });
+
+    if (stopping)
+        return Mat();
+
+    Mat img = decoded[idx];
+    decoded.erase(idx);
+    nexttake = idx + 1;
+    lock.unlock();
+
+    // A decoder may proceed with the next file.
+    cond.notify_all();
+
+    return img;
+}
+
+void ImagePrefetcher::work()
+{
+    unique_lock<mutex> lock(mtx);
+
+    while (1)
+    {
+        cond.wait(lock, [&] { return stopping || nextdecode >= static_cast<int>(filelist.size()) || nextdecode < nexttake + capacity; });
+
+        if (stopping || nextdecode >= static_cast<int>(filelist.size()))
+            break;
+
+        int idx = nextdecode++;
+        lock.unlock();
+
+        QString filename = filelist[idx];
+        Mat img = cvutil::imread(filename);
+
+        if (img.channels() == 3)
+            cvtColor(img, img, COLOR_BGR2RGB);
+
+        lock.lock();
+        decoded[idx] = img;
+        cond.notify_all();
+    }
+}
@@ -0,0 +1,77 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: ImagePrefetcher.h
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef IMAGEPREFETCHER_H
+#define IMAGEPREFETCHER_H
+
+#include <QtCore/QStringList>
+
+#include <opencv2/core.hpp>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Decode stage of the batch pipeline. Decoder threads read and decode
+// the images of the file list, starting at a given index, while the
+// caller processes the earlier ones. The decoders run at most capacity
+// files ahead of the file taken last, so the memory held by the decoded
+// images is bounded. The images are taken in file order, irrespective
+// of the order in which the decoders finish them.
+class ImagePrefetcher
+{
+    QStringList filelist;
+    int capacity;
+
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::map<int, cv::Mat> decoded;
+    std::vector<std::thread> decoders;
+    int nextdecode;     // Next file to be given to a decoder
+    int nexttake;       // Next file to be taken by the caller
+    bool stopping = false;
+
+    void work();
+
+public:
+    ImagePrefetcher(QStringList flist, int first, int ndecoders = 2, int capacity = 4);
+    ~ImagePrefetcher();
+
+    // Blocks until the image of file idx is decoded. Color images are
+    // converted to RGB. The files must be taken in increasing order.
+    cv::Mat take(int idx);
+
+    // Stops the decoders and drops the images that were not taken.
+    void stop();
+};
+
+#endif
@@ -28,6 +28,7 @@ along with cvutil; see the file COPYING.  If not, see
 
 #include "helper_functions.h"
 
+#include <QtCore/QDir>
 #include <QtCore/QString>
 
 // Helper function to split a string into numeric and non-numeric parts
@@ -88,3 +89,17 @@ void natsort(QStringList& vec)
 {
     std::sort(vec.begin(), vec.end(), naturalCompare);
 }
+
+QStringList getimagefiles(QString imgpath)
+{
+    QStringList filelist;
+    QDir dir(imgpath);
+    QStringList images = dir.entryList(QStringList() 
+        << "*.png" << "*.PNG" << "*.jpg" << "*.JPG" << "*.bmp" << "*.BMP" << "*.jpeg" << "*.JPEG" << "*.jpe" << "*.JPE"
+        << "*.dib" << "*.DIB" << "*.jp2" << "*.JP2" << "*.tiff" << "*.TIFF" << "*.tif" << "*.TIF", QDir::Files);
+    natsort(images);
+    for (auto image : images)
+        filelist.push_back(imgpath + image);
+
+    return filelist;
+}
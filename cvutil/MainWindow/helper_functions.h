@@ -32,3 +32,7 @@ along with cvutil; see the file COPYING.  If not, see
 
 void natsort(QStringList& vec);
 
+// Returns the paths of the image files in the directory imgpath (which
+// must end with a path separator) in natural sorting order.
+QStringList getimagefiles(QString imgpath);
+
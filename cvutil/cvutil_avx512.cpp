@@ -0,0 +1,509 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_avx512.cpp
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#include "cvutil_avx512.h"
+
+#include <cfloat>
+#include <immintrin.h>
+
+#pragma warning(disable : 4752)
+
+// AVX-512 variant of horizontal_st_avx, scanning 16 rows at a time.
+// The parabola vertices and intersections of lane p are stored at
+// v[k * 16 + p] and z[k * 16 + p].
+int avx512_helper::bwdist_rows(float *resultptr, const int *a, int *v, float *z, int ncol, int nstart, int nend)
+{
+    int i, j;
+    int stepsize = 16;
+    __mmask16 mask;
+
+    __m512i vlane, vk, vofkidx, vofk, vi, va, tone, vjv;
+    __m512 fbuf, fbuf1, fbuf2, fbuf3, fbuf4, flt, zofk;
+
+    vlane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    flt = _mm512_set1_ps(FLT_MAX);
+    tone = _mm512_set1_epi32(1);
+
+    for (i = nstart; (i + stepsize) <= nend; i += stepsize)
+    {
+        _mm512_storeu_si512(&v[0], _mm512_setzero_si512());
+        _mm512_storeu_ps(&z[0], _mm512_set1_ps(-FLT_MAX));
+        _mm512_storeu_ps(&z[stepsize], flt);
+        vk = _mm512_setzero_si512();
+        vi = _mm512_loadu_si512(&a[i]);
+
+        for (j = 1; j < ncol; j++)
+        {
+            vjv = _mm512_set1_epi32(j);
+            fbuf4 = _mm512_set1_ps(float(j));
+
+            // Get resultptr[a[i] + j]
+            fbuf = _mm512_i32gather_ps(_mm512_add_epi32(vi, vjv), resultptr, 4);
+
+            // Get v[k] and z[k]
+            vofkidx = _mm512_add_epi32(_mm512_slli_epi32(vk, 4), vlane);
+            vofk = _mm512_i32gather_epi32(vofkidx, v, 4);
+            zofk = _mm512_i32gather_ps(vofkidx, z, 4);
+
+            // Get resultptr[a[i] + v[k]]
+            va = _mm512_add_epi32(vi, vofk);
+            fbuf1 = _mm512_i32gather_ps(va, resultptr, 4);
+
+            fbuf2 = _mm512_cvtepi32_ps(vofk);
+            fbuf1 = _mm512_sub_ps(fbuf, fbuf1);             // resultptr[a[i] + j] - resultptr[a[i] + v[k]]
+            fbuf3 = _mm512_sub_ps(fbuf4, fbuf2);            // (j - v[k])
+            fbuf2 = _mm512_add_ps(fbuf4, fbuf2);            // (j + v[k])
+            fbuf1 = _mm512_fmadd_ps(fbuf3, fbuf2, fbuf1);   // (resultptr[a[i] + j] - resultptr[a[i] + v[k]] + (j * j - v[k] * v[k]))
+            fbuf3 = _mm512_add_ps(fbuf3, fbuf3);            // 2 * (j - v[k])
+
+            fbuf3 = _mm512_div_ps(fbuf1, fbuf3);            // s value computed
+
+            mask = _mm512_cmp_ps_mask(fbuf3, zofk, _CMP_LE_OQ);
+
+            while (mask)
+            {
+                // k-- only in the lanes where s <= z[k]
+                vk = _mm512_mask_sub_epi32(vk, mask, vk, tone);
+
+                vofkidx = _mm512_add_epi32(_mm512_slli_epi32(vk, 4), vlane);
+                vofk = _mm512_i32gather_epi32(vofkidx, v, 4);
+                zofk = _mm512_i32gather_ps(vofkidx, z, 4);
+
+                va = _mm512_add_epi32(vi, vofk);
+                fbuf1 = _mm512_i32gather_ps(va, resultptr, 4);
+
+                fbuf2 = _mm512_cvtepi32_ps(vofk);
+                fbuf1 = _mm512_sub_ps(fbuf, fbuf1);
+                fbuf3 = _mm512_sub_ps(fbuf4, fbuf2);
+                fbuf2 = _mm512_add_ps(fbuf4, fbuf2);
+                fbuf1 = _mm512_fmadd_ps(fbuf3, fbuf2, fbuf1);
+                fbuf3 = _mm512_add_ps(fbuf3, fbuf3);
+
+                fbuf3 = _mm512_div_ps(fbuf1, fbuf3);            // s value updated
+
+                mask = _mm512_cmp_ps_mask(fbuf3, zofk, _CMP_LE_OQ);
+            }
+
+            // k++; v[k] = j; z[k] = s; z[k + 1] = FLT_MAX;
+            // The lanes write to different locations, so the scatters
+            // do not conflict.
+            vk = _mm512_add_epi32(vk, tone);
+            vofkidx = _mm512_add_epi32(_mm512_slli_epi32(vk, 4), vlane);
+            _mm512_i32scatter_epi32(v, vofkidx, vjv, 4);
+            _mm512_i32scatter_ps(z, vofkidx, fbuf3, 4);
+            _mm512_i32scatter_ps(z, _mm512_add_epi32(vofkidx, _mm512_set1_epi32(stepsize)), flt, 4);
+        }
+
+        // Second loop to assign the distance transform values
+        vk = _mm512_setzero_si512();
+        vofkidx = vlane;
+        zofk = _mm512_i32gather_ps(_mm512_add_epi32(vofkidx, _mm512_set1_epi32(stepsize)), z, 4);
+
+        for (j = 0; j < ncol; j++)
+        {
+            fbuf4 = _mm512_set1_ps(float(j));
+            mask = _mm512_cmp_ps_mask(zofk, fbuf4, _CMP_LT_OQ);
+
+            while (mask)
+            {
+                vk = _mm512_mask_add_epi32(vk, mask, vk, tone);
+                vofkidx = _mm512_add_epi32(_mm512_slli_epi32(vk, 4), vlane);
+                zofk = _mm512_i32gather_ps(_mm512_add_epi32(vofkidx, _mm512_set1_epi32(stepsize)), z, 4);
+                mask = _mm512_cmp_ps_mask(zofk, fbuf4, _CMP_LT_OQ);
+            }
+
+            vofk = _mm512_i32gather_epi32(vofkidx, v, 4);
+
+            // Get resultptr[a[i] + v[k]]
+            va = _mm512_add_epi32(vi, vofk);
+            fbuf1 = _mm512_i32gather_ps(va, resultptr, 4);
+
+            fbuf2 = _mm512_cvtepi32_ps(vofk);
+            fbuf4 = _mm512_sub_ps(fbuf4, fbuf2);            // Compute (j - v[k])
+            fbuf1 = _mm512_fmadd_ps(fbuf4, fbuf4, fbuf1);   // Compute ((j - v[k]) * (j - v[k]) + resultptr[a[i] + v[k]])
+
+            _mm512_i32scatter_ps(resultptr, _mm512_add_epi32(vi, _mm512_set1_epi32(j)), fbuf1, 4);
+        }
+    }
+
+    return i;
+}
+
+// AVX-512 variant of vertical_st_avx, scanning strips of 16 columns
+// through a row-contiguous scratch buffer f.
+int avx512_helper::bwdist_cols(float *resultptr, const int *a, int *v, float *z, float *d, float *f, int nrow, int nstart, int nend)
+{
+    int i, j;
+    int stepsize = 16;
+    __mmask16 mask;
+
+    __m512i vlane, vk, vofkidx, vofk, va, tone, vstepv;
+    __m512 fbuf, fbuf1, fbuf2, fbuf3, fbuf4, flt, zofk;
+
+    vlane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    flt = _mm512_set1_ps(FLT_MAX);
+    tone = _mm512_set1_epi32(1);
+    vstepv = _mm512_set1_epi32(stepsize);
+
+    for (j = nstart; (j + stepsize) <= nend; j += stepsize)
+    {
+        for (i = 0; i < nrow; i++)
+            _mm512_storeu_ps(&f[i * stepsize], _mm512_loadu_ps(&resultptr[a[i] + j]));
+
+        _mm512_storeu_si512(&v[0], _mm512_setzero_si512());
+        _mm512_storeu_ps(&z[0], _mm512_set1_ps(-FLT_MAX));
+        _mm512_storeu_ps(&z[stepsize], flt);
+        vk = _mm512_setzero_si512();
+
+        for (i = 1; i < nrow; i++)
+        {
+            fbuf4 = _mm512_set1_ps(float(i));
+
+            // Get f[i][p]
+            fbuf = _mm512_loadu_ps(&f[i * stepsize]);
+
+            // Get v[k] and z[k]
+            vofkidx = _mm512_add_epi32(_mm512_slli_epi32(vk, 4), vlane);
+            vofk = _mm512_i32gather_epi32(vofkidx, v, 4);
+            zofk = _mm512_i32gather_ps(vofkidx, z, 4);
+
+            // Get f[v[k]][p]
+            va = _mm512_add_epi32(_mm512_slli_epi32(vofk, 4), vlane);
+            fbuf1 = _mm512_i32gather_ps(va, f, 4);
+
+            fbuf2 = _mm512_cvtepi32_ps(vofk);
+            fbuf1 = _mm512_sub_ps(fbuf, fbuf1);             // f[i][p] - f[v[k]][p]
+            fbuf3 = _mm512_sub_ps(fbuf4, fbuf2);            // (i - v[k])
+            fbuf2 = _mm512_add_ps(fbuf4, fbuf2);            // (i + v[k])
+            fbuf1 = _mm512_fmadd_ps(fbuf3, fbuf2, fbuf1);   // (f[i][p] - f[v[k]][p] + (i * i - v[k] * v[k]))
+            fbuf3 = _mm512_add_ps(fbuf3, fbuf3);            // 2 * (i - v[k])
+
+            fbuf3 = _mm512_div_ps(fbuf1, fbuf3);            // s value computed
+
+            mask = _mm512_cmp_ps_mask(fbuf3, zofk, _CMP_LE_OQ);
+
+            while (mask)
+            {
+                vk = _mm512_mask_sub_epi32(vk, mask, vk, tone);
+
+                vofkidx = _mm512_add_epi32(_mm512_slli_epi32(vk, 4), vlane);
+                vofk = _mm512_i32gather_epi32(vofkidx, v, 4);
+                zofk = _mm512_i32gather_ps(vofkidx, z, 4);
+
+                va = _mm512_add_epi32(_mm512_slli_epi32(vofk, 4), vlane);
+                fbuf1 = _mm512_i32gather_ps(va, f, 4);
+
+                fbuf2 = _mm512_cvtepi32_ps(vofk);
+                fbuf1 = _mm512_sub_ps(fbuf, fbuf1);
+                fbuf3 = _mm512_sub_ps(fbuf4, fbuf2);
+                fbuf2 = _mm512_add_ps(fbuf4, fbuf2);
+                fbuf1 = _mm512_fmadd_ps(fbuf3, fbuf2, fbuf1);
+                fbuf3 = _mm512_add_ps(fbuf3, fbuf3);
+
+                fbuf3 = _mm512_div_ps(fbuf1, fbuf3);            // s value updated
+
+                mask = _mm512_cmp_ps_mask(fbuf3, zofk, _CMP_LE_OQ);
+            }
+
+            vk = _mm512_add_epi32(vk, tone);
+            vofkidx = _mm512_add_epi32(_mm512_slli_epi32(vk, 4), vlane);
+            _mm512_i32scatter_epi32(v, vofkidx, _mm512_set1_epi32(i), 4);
+            _mm512_i32scatter_ps(z, vofkidx, fbuf3, 4);
+            _mm512_i32scatter_ps(z, _mm512_add_epi32(vofkidx, vstepv), flt, 4);
+        }
+
+        // Second loop to assign the distance transform values
+        vk = _mm512_setzero_si512();
+        vofkidx = vlane;
+        zofk = _mm512_i32gather_ps(_mm512_add_epi32(vofkidx, vstepv), z, 4);
+
+        for (i = 0; i < nrow; i++)
+        {
+            fbuf4 = _mm512_set1_ps(float(i));
+            mask = _mm512_cmp_ps_mask(zofk, fbuf4, _CMP_LT_OQ);
+
+            while (mask)
+            {
+                vk = _mm512_mask_add_epi32(vk, mask, vk, tone);
+                vofkidx = _mm512_add_epi32(_mm512_slli_epi32(vk, 4), vlane);
+                zofk = _mm512_i32gather_ps(_mm512_add_epi32(vofkidx, vstepv), z, 4);
+                mask = _mm512_cmp_ps_mask(zofk, fbuf4, _CMP_LT_OQ);
+            }
+
+            vofk = _mm512_i32gather_epi32(vofkidx, v, 4);
+
+            // Get f[v[k]][p]
+            va = _mm512_add_epi32(_mm512_slli_epi32(vofk, 4), vlane);
+            fbuf1 = _mm512_i32gather_ps(va, f, 4);
+
+            fbuf2 = _mm512_cvtepi32_ps(vofk);
+            fbuf4 = _mm512_sub_ps(fbuf4, fbuf2);            // Compute (i - v[k])
+            fbuf1 = _mm512_fmadd_ps(fbuf4, fbuf4, fbuf1);   // Compute ((i - v[k]) * (i - v[k]) + f[v[k]][p])
+
+            _mm512_storeu_ps(&d[i * stepsize], fbuf1);
+        }
+
+        // Values below 2 are 0 or 1, for which the square root is the
+        // value itself.
+        fbuf1 = _mm512_set1_ps(2.0f);
+        for (i = 0; i < nrow; i++)
+        {
+            fbuf = _mm512_loadu_ps(&d[i * stepsize]);
+            mask = _mm512_cmp_ps_mask(fbuf, fbuf1, _CMP_LT_OQ);
+
+            if (mask == 0xffff)
+                _mm512_storeu_ps(&resultptr[a[i] + j], fbuf);
+            else
+                _mm512_storeu_ps(&resultptr[a[i] + j], _mm512_sqrt_ps(fbuf));
+        }
+    }
+
+    return j;
+}
+
+int avx512_helper::floor_ps(float *data, int nelements)
+{
+    __m512 buffer;
+    int i = 0;
+
+    for (; (i + 16) <= nelements; i += 16)
+    {
+        buffer = _mm512_loadu_ps(&data[i]);
+        buffer = _mm512_roundscale_ps(buffer, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        _mm512_storeu_ps(&data[i], buffer);
+    }
+
+    return i;
+}
+
+int avx512_helper::floor_pd(double *data, int nelements)
+{
+    __m512d buffer;
+    int i = 0;
+
+    for (; (i + 8) <= nelements; i += 8)
+    {
+        buffer = _mm512_loadu_pd(&data[i]);
+        buffer = _mm512_roundscale_pd(buffer, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        _mm512_storeu_pd(&data[i], buffer);
+    }
+
+    return i;
+}
+
+int avx512_helper::ceil_ps(float *data, int nelements)
+{
+    __m512 buffer;
+    int i = 0;
+
+    for (; (i + 16) <= nelements; i += 16)
+    {
+        buffer = _mm512_loadu_ps(&data[i]);
+        buffer = _mm512_roundscale_ps(buffer, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+        _mm512_storeu_ps(&data[i], buffer);
+    }
+
+    return i;
+}
+
+int avx512_helper::ceil_pd(double *data, int nelements)
+{
+    __m512d buffer;
+    int i = 0;
+
+    for (; (i + 8) <= nelements; i += 8)
+    {
+        buffer = _mm512_loadu_pd(&data[i]);
+        buffer = _mm512_roundscale_pd(buffer, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+        _mm512_storeu_pd(&data[i], buffer);
+    }
+
+    return i;
+}
+
+// Non-zero mask of the 16 elements starting at inpptr. The
+// integer types are widened to 32-bit lanes, so only AVX-512F
+// instructions are needed.
+static inline __mmask16 nonzero_mask16(const unsigned char* inpptr)
+{
+    __m512i buffer = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)inpptr));
+    return _mm512_test_epi32_mask(buffer, buffer);
+}
+
+static inline __mmask16 nonzero_mask16(const char* inpptr)
+{
+    __m512i buffer = _mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i *)inpptr));
+    return _mm512_test_epi32_mask(buffer, buffer);
+}
+
+static inline __mmask16 nonzero_mask16(const unsigned short* inpptr)
+{
+    __m512i buffer = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *)inpptr));
+    return _mm512_test_epi32_mask(buffer, buffer);
+}
+
+static inline __mmask16 nonzero_mask16(const short* inpptr)
+{
+    __m512i buffer = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *)inpptr));
+    return _mm512_test_epi32_mask(buffer, buffer);
+}
+
+static inline __mmask16 nonzero_mask16(const int* inpptr)
+{
+    __m512i buffer = _mm512_loadu_si512(inpptr);
+    return _mm512_test_epi32_mask(buffer, buffer);
+}
+
+// Floating point values are compared against zero, so that -0.0
+// is treated as zero and NaN as non-zero (as in the scalar code).
+static inline __mmask16 nonzero_mask16(const float* inpptr)
+{
+    return _mm512_cmp_ps_mask(_mm512_loadu_ps(inpptr), _mm512_setzero_ps(), _CMP_NEQ_UQ);
+}
+
+static inline __mmask16 nonzero_mask16(const double* inpptr)
+{
+    __mmask8 lo = _mm512_cmp_pd_mask(_mm512_loadu_pd(inpptr), _mm512_setzero_pd(), _CMP_NEQ_UQ);
+    __mmask8 hi = _mm512_cmp_pd_mask(_mm512_loadu_pd(inpptr + 8), _mm512_setzero_pd(), _CMP_NEQ_UQ);
+    return __mmask16(lo | (hi << 8));
+}
+
+// Bit count of the mask. std::bitset is not used here, as its inline
+// functions would be compiled with the AVX-512 instructions and may be
+// picked by the linker for the rest of the library.
+static inline int popcount16(__mmask16 mask)
+{
+    unsigned int x = mask;
+
+    x = x - ((x >> 1) & 0x5555);
+    x = (x & 0x3333) + ((x >> 2) & 0x3333);
+    x = (x + (x >> 4)) & 0x0f0f;
+
+    return int((x + (x >> 8)) & 0x1f);
+}
+
+// Forward find of the linear indices, 16 elements at a time.
+// The indices of the non-zero elements are packed into the output
+// using the compress store instruction.
+template<typename T>
+void avx512_helper::find_indices(T* inpptr, int* indsubptr, int nelements, int nNonZeros)
+{
+    const T zero = static_cast<T>(0);
+    __m512i vidx = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i vstep = _mm512_set1_epi32(16);
+    __mmask16 mask;
+    int i = 0, j = 0, count;
+
+    for (; (i + 16) <= nelements; i += 16)
+    {
+        mask = nonzero_mask16(&inpptr[i]);
+        count = popcount16(mask);
+
+        // The output can only hold nNonZeros elements.
+        if ((j + count) > nNonZeros)
+            break;
+
+        _mm512_mask_compressstoreu_epi32(&indsubptr[j], mask, vidx);
+        j += count;
+        vidx = _mm512_add_epi32(vidx, vstep);
+    }
+
+    for (; (i < nelements && j < nNonZeros); i++)
+    {
+        if (inpptr[i] != zero)
+        {
+            indsubptr[j] = i;
+            j++;
+        }
+    }
+}
+
+// Forward find of the row and column subscripts of a single
+// channel matrix, 16 columns at a time.
+template<typename T>
+void avx512_helper::find_subscripts(T* inpptr, int* indsubptr, int nelements, int nNonZeros, int ncols)
+{
+    const T zero = static_cast<T>(0);
+    int nrows = nelements / ncols;
+    alignas(64) int cols[16];
+    __m512i vstep = _mm512_set1_epi32(16);
+    __m512i vidx;
+    __mmask16 mask;
+    int r, c, k, count, j = 0;
+
+    for (r = 0; (r < nrows && j < nNonZeros); r++)
+    {
+        T *rowptr = inpptr + r * ncols;
+        vidx = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+        for (c = 0; (c + 16) <= ncols && j < nNonZeros; c += 16)
+        {
+            mask = nonzero_mask16(&rowptr[c]);
+
+            if (mask)
+            {
+                count = popcount16(mask);
+                _mm512_mask_compressstoreu_epi32(cols, mask, vidx);
+
+                for (k = 0; (k < count && j < nNonZeros); k++, j++)
+                {
+                    indsubptr[j * 2] = r;
+                    indsubptr[j * 2 + 1] = cols[k];
+                }
+            }
+
+            vidx = _mm512_add_epi32(vidx, vstep);
+        }
+
+        for (; (c < ncols && j < nNonZeros); c++)
+        {
+            if (rowptr[c] != zero)
+            {
+                indsubptr[j * 2] = r;
+                indsubptr[j * 2 + 1] = c;
+                j++;
+            }
+        }
+    }
+}
+
+template void avx512_helper::find_indices<unsigned char>(unsigned char*, int*, int, int);
+template void avx512_helper::find_indices<char>(char*, int*, int, int);
+template void avx512_helper::find_indices<unsigned short>(unsigned short*, int*, int, int);
+template void avx512_helper::find_indices<short>(short*, int*, int, int);
+template void avx512_helper::find_indices<int>(int*, int*, int, int);
+template void avx512_helper::find_indices<float>(float*, int*, int, int);
+template void avx512_helper::find_indices<double>(double*, int*, int, int);
+
+template void avx512_helper::find_subscripts<unsigned char>(unsigned char*, int*, int, int, int);
+template void avx512_helper::find_subscripts<char>(char*, int*, int, int, int);
+template void avx512_helper::find_subscripts<unsigned short>(unsigned short*, int*, int, int, int);
+template void avx512_helper::find_subscripts<short>(short*, int*, int, int, int);
+template void avx512_helper::find_subscripts<int>(int*, int*, int, int, int);
+template void avx512_helper::find_subscripts<float>(float*, int*, int, int, int);
+template void avx512_helper::find_subscripts<double>(double*, int*, int, int, int);
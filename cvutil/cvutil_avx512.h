@@ -0,0 +1,69 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_avx512.h
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef CVUTIL_AVX512_H
+#define CVUTIL_AVX512_H
+
+// AVX-512 kernels, compiled in a separate translation unit with the
+// AVX-512F code generation flags so that the rest of the library keeps
+// the baseline instruction set. The callers must check for the CPU
+// support with checkHardwareSupport(CPU_AVX_512F) before calling any
+// of these functions. The interface only uses plain pointers, so that
+// no OpenCV or standard library inline functions are compiled with
+// the AVX-512 instructions.
+namespace avx512_helper
+{
+    // Horizontal and vertical passes of bwdist over rows (columns)
+    // nstart to nend of resultptr, 16 rows (columns) at a time. a holds
+    // the row offsets, and v, z (and d, f) are the 16 lane scratch
+    // buffers of the caller. Return the first row (column) that is not
+    // processed, which is left for the scalar code.
+    int bwdist_rows(float *resultptr, const int *a, int *v, float *z, int ncol, int nstart, int nend);
+    int bwdist_cols(float *resultptr, const int *a, int *v, float *z, float *d, float *f, int nrow, int nstart, int nend);
+
+    // Round the first elements of data down (floor) or up (ceil) in
+    // place. Return the number of elements processed, the remaining
+    // ones are left for the scalar code.
+    int floor_ps(float *data, int nelements);
+    int floor_pd(double *data, int nelements);
+    int ceil_ps(float *data, int nelements);
+    int ceil_pd(double *data, int nelements);
+
+    // Forward find of the linear indices and of the row and column
+    // subscripts of a single channel matrix. Instantiated for the
+    // element types of cv::Mat, except float16.
+    template<typename T>
+    void find_indices(T* inpptr, int* indsubptr, int nelements, int nNonZeros);
+
+    template<typename T>
+    void find_subscripts(T* inpptr, int* indsubptr, int nelements, int nNonZeros, int ncols);
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_baseline.cpp
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#include "cvutil_baseline.h"
+
+#include <cfloat>
+#include <cmath>
+
+// One dimensional distance transform of the squared distances in f
+// (of length n), written to d. v and z are scratch buffers of size n
+// and n + 1.
+static void dt1d_scalar(const float *f, float *d, int n, int *v, float *z)
+{
+    int q, k = 0;
+    float s;
+
+    v[0] = 0;
+    z[0] = -FLT_MAX; z[1] = FLT_MAX;
+
+    for (q = 1; q < n; q++)
+    {
+        s = (f[q] - f[v[k]] + (q * q - v[k] * v[k])) / float(2 * (q - v[k]));
+
+        while (s <= z[k])
+        {
+            k--;
+            s = (f[q] - f[v[k]] + (q * q - v[k] * v[k])) / float(2 * (q - v[k]));
+        }
+
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = FLT_MAX;
+    }
+
+    for (q = 0, k = 0; q < n; q++)
+    {
+        while (z[k + 1] < q)
+            k++;
+
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+void baseline_helper::bwdist_rows(float *resultptr, size_t rstep, int ncol, int nstart, int nend, int *v, float *z, float *d)
+{
+    int i, j;
+
+    for (i = nstart; i < nend; i++)
+    {
+        float *rowptr = resultptr + i * rstep;
+        dt1d_scalar(rowptr, d, ncol, v, z);
+
+        for (j = 0; j < ncol; j++)
+            rowptr[j] = d[j];
+    }
+}
+
+// The strips of columns are copied into a column-contiguous scratch
+// buffer, so that the scans run on contiguous memory.
+void baseline_helper::bwdist_cols(float *resultptr, size_t rstep, int nrow, int nstart, int nend, int *v, float *z, float *d, float *f)
+{
+    int i, j, p, width;
+
+    for (j = nstart; j < nend; j += bwdist_strip)
+    {
+        width = (nend - j < bwdist_strip) ? (nend - j) : bwdist_strip;
+
+        // Column p of the strip is at f[p * nrow].
+        for (i = 0; i < nrow; i++)
+        {
+            float *rowptr = resultptr + i * rstep + j;
+            for (p = 0; p < width; p++)
+                f[size_t(p) * nrow + i] = rowptr[p];
+        }
+
+        for (p = 0; p < width; p++)
+        {
+            float *colptr = f + size_t(p) * nrow;
+            dt1d_scalar(colptr, d, nrow, v, z);
+
+            for (i = 0; i < nrow; i++)
+                colptr[i] = (d[i] >= 2) ? sqrtf(d[i]) : d[i];
+        }
+
+        for (i = 0; i < nrow; i++)
+        {
+            float *rowptr = resultptr + i * rstep + j;
+            for (p = 0; p < width; p++)
+                rowptr[p] = f[size_t(p) * nrow + i];
+        }
+    }
+}
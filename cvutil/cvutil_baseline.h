@@ -0,0 +1,58 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_baseline.h
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef CVUTIL_BASELINE_H
+#define CVUTIL_BASELINE_H
+
+#include <cstddef>
+
+// Kernels for the CPUs without AVX2, compiled in a separate translation
+// unit without the AVX2/FMA code generation flags of the rest of the
+// library, so that the compiler does not vectorize them with AVX2. As in
+// cvutil_avx512.h, the interface only uses plain pointers.
+namespace baseline_helper
+{
+    // Number of columns the vertical pass of bwdist copies to its
+    // scratch buffer at a time.
+    const int bwdist_strip = 16;
+
+    // Horizontal pass of bwdist over rows nstart to nend of resultptr,
+    // whose rows are rstep elements apart. v, z and d are scratch
+    // buffers of max(ncol, nrow), max(ncol, nrow) + 1 and
+    // max(ncol, nrow) elements.
+    void bwdist_rows(float *resultptr, size_t rstep, int ncol, int nstart, int nend, int *v, float *z, float *d);
+
+    // Vertical pass of bwdist over columns nstart to nend, including the
+    // square root of the distances. f is a scratch buffer of
+    // bwdist_strip * nrow elements.
+    void bwdist_cols(float *resultptr, size_t rstep, int nrow, int nstart, int nend, int *v, float *z, float *d, float *f);
+}
+
+#endif
@@ -0,0 +1,144 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_bitimage.cpp
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+// Binary images in cvutil are CV_8UC1 images holding 0 or 255, so the
+// morphology kernels move 8 bits for every pixel. BitImage packs 64
+// pixels in a word, so that the neighborhood of a whole word of pixels
+// is obtained with a few shifts.
+
+#include "cvutil_bitimage.h"
+
+#include "cvutil.h"
+
+#include <bitset>
+
+using namespace std;
+using namespace cv;
+using namespace bitimage_helper;
+
+// Packs 64 bytes into a word, with a bit set for every non-zero byte.
+static inline uint64_t pack64_avx(const uchar *src)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 32));
+    uint32_t zlo = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, zero)));
+    uint32_t zhi = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, zero)));
+
+    return ~((uint64_t(zhi) << 32) | zlo);
+}
+
+static inline uint64_t pack_scalar(const uchar *src, int n)
+{
+    uint64_t word = 0;
+
+    for (int i = 0; i < n; i++)
+        if (src[i])
+            word |= uint64_t(1) << i;
+
+    return word;
+}
+
+void BitImage::create(int rows, int cols)
+{
+    nrows = rows;
+    ncols = cols;
+    nwords = (cols + 63) >> 6;
+    nstride = (nwords + 3) & ~3;
+    bits.assign(size_t(nrows) * nstride, 0);
+}
+
+void BitImage::fromMat(const Mat& m)
+{
+    CV_ASSERT2(m.channels() == 1, "m must be a single channel image.");
+
+    Mat src = m;
+
+    if (src.depth() != CV_8U && src.depth() != CV_8S)
+        src = (m != 0);
+
+    create(src.rows, src.cols);
+
+    bool useavx = checkHardwareSupport(CPU_AVX2);
+    int nfull = ncols >> 6;
+
+    for (int r = 0; r < nrows; r++)
+    {
+        const uchar *srow = src.ptr<uchar>(r);
+        uint64_t *brow = ptr(r);
+        int w = 0;
+
+        if (useavx)
+            for (; w < nfull; w++)
+                brow[w] = pack64_avx(srow + (w << 6));
+
+        for (; w < nfull; w++)
+            brow[w] = pack_scalar(srow + (w << 6), 64);
+
+        if (nfull < nwords)
+            brow[nfull] = pack_scalar(srow + (nfull << 6), ncols & 63);
+    }
+}
+
+Mat BitImage::toMat() const
+{
+    Mat m(nrows, ncols, CV_8UC1);
+
+    for (int r = 0; r < nrows; r++)
+    {
+        const uint64_t *brow = ptr(r);
+        uchar *drow = m.ptr<uchar>(r);
+
+        for (int w = 0; w < nwords; w++)
+        {
+            uint64_t word = brow[w];
+            int n = min(64, ncols - (w << 6));
+            uchar *dst = drow + (w << 6);
+
+            for (int i = 0; i < n; i++)
+                dst[i] = ((word >> i) & 1) ? 255 : 0;
+        }
+    }
+
+    return m;
+}
+
+size_t BitImage::count() const
+{
+    size_t total = 0;
+
+    for (int r = 0; r < nrows; r++)
+    {
+        const uint64_t *brow = ptr(r);
+
+        for (int w = 0; w < nwords; w++)
+            total += bitset<64>(brow[w]).count();
+    }
+
+    return total;
+}
@@ -0,0 +1,178 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_bitimage.h
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef CVUTIL_BITIMAGE_H
+#define CVUTIL_BITIMAGE_H
+
+#include "stdproto.h"
+
+#include <cstdint>
+
+namespace bitimage_helper
+{
+    // Bit-packed binary image. Each row is stored in its own run of
+    // 64-bit words, with pixel (r, c) at bit (c % 64) of word (c / 64)
+    // of row r, so that the pixel on the right of a pixel is the next
+    // higher bit. The bits past the last column of a row are always 0,
+    // and the row stride is a multiple of 4 words so that each row can
+    // be processed with full 256-bit vectors.
+    class BitImage
+    {
+        int nrows = 0, ncols = 0;
+        int nwords = 0;     // Words holding the pixels of a row
+        int nstride = 0;    // Words between the starts of two rows
+        std::vector<uint64_t> bits;
+
+    public:
+        BitImage() {}
+        BitImage(int rows, int cols) { create(rows, cols); }
+
+        // Non-zero pixels of the single channel image m are set to 1.
+        explicit BitImage(const cv::Mat& m) { fromMat(m); }
+
+        // Allocates a rows x cols image with all the pixels set to 0.
+        void create(int rows, int cols);
+
+        void fromMat(const cv::Mat& m);
+
+        // Returns a CV_8UC1 image with the pixels set to 0 or 255.
+        cv::Mat toMat() const;
+
+        int rows() const { return nrows; }
+        int cols() const { return ncols; }
+        int words() const { return nwords; }
+        int stride() const { return nstride; }
+        bool empty() const { return bits.empty(); }
+
+        uint64_t *ptr(int r) { return bits.data() + size_t(r) * nstride; }
+        const uint64_t *ptr(int r) const { return bits.data() + size_t(r) * nstride; }
+
+        bool get(int r, int c) const { return (ptr(r)[c >> 6] >> (c & 63)) & 1; }
+
+        void set(int r, int c, bool value)
+        {
+            uint64_t mask = uint64_t(1) << (c & 63);
+
+            if (value)
+                ptr(r)[c >> 6] |= mask;
+            else
+                ptr(r)[c >> 6] &= ~mask;
+        }
+
+        // Number of pixels set to 1.
+        size_t count() const;
+
+        // Mask of the valid pixels in the last word of a row.
+        uint64_t lastmask() const
+        {
+            return ((ncols & 63) == 0) ? ~uint64_t(0) : ((uint64_t(1) << (ncols & 63)) - 1);
+        }
+    };
+
+    // Gathers the 8-neighbors of the 64 pixels held in word w of a row.
+    // up, mid and down are the previous, current and next rows (null for
+    // the rows outside the image), and nwords is the number of words in
+    // a row. The neighbors are numbered as in the bwthin() tables,
+    //
+    //      X3  X2  X1
+    //      X4  P   X0
+    //      X5  X6  X7
+    //
+    // so that bit i of x[k] is the k-th neighbor of the i-th pixel.
+    inline void neighbors(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+        int w, int nwords, uint64_t x[8])
+    {
+        auto west = [&](const uint64_t *row) -> uint64_t
+        {
+            if (row == nullptr)
+                return 0;
+            return (row[w] << 1) | ((w > 0) ? (row[w - 1] >> 63) : 0);
+        };
+
+        auto east = [&](const uint64_t *row) -> uint64_t
+        {
+            if (row == nullptr)
+                return 0;
+            return (row[w] >> 1) | ((w < nwords - 1) ? (row[w + 1] << 63) : 0);
+        };
+
+        x[0] = east(mid);
+        x[1] = east(up);
+        x[2] = (up != nullptr) ? up[w] : 0;
+        x[3] = west(up);
+        x[4] = west(mid);
+        x[5] = west(down);
+        x[6] = (down != nullptr) ? down[w] : 0;
+        x[7] = east(down);
+    }
+
+    // Bit-sliced form of the conditions shared by the lut1 and lut2
+    // tables of bwthin(), Xh(p) = 1 and 2 <= min{n1(p), n2(p)} <= 3,
+    // evaluated for the 64 pixels at once. The key of the i-th pixel is
+    // formed by bit i of the x[k] words.
+    inline uint64_t thin_common(const uint64_t x[8])
+    {
+        uint64_t b[4], a[4], c[4];
+
+        for (int j = 0; j < 4; j++)
+        {
+            uint64_t x0 = x[2 * j], x1 = x[2 * j + 1], x2 = x[(2 * j + 2) & 7];
+
+            b[j] = ~x0 & (x1 | x2);
+            a[j] = x0 | x1;
+            c[j] = x1 | x2;
+        }
+
+        // Exactly one of the four b's is set.
+        uint64_t xh = ((b[0] ^ b[1]) & ~(b[2] | b[3])) | ((b[2] ^ b[3]) & ~(b[0] | b[1]));
+
+        // At least two of the four terms of n1 and n2 are set, and not
+        // all four terms of both of them.
+        uint64_t n1ge2 = (a[0] & a[1]) | (a[2] & a[3]) | ((a[0] | a[1]) & (a[2] | a[3]));
+        uint64_t n2ge2 = (c[0] & c[1]) | (c[2] & c[3]) | ((c[0] | c[1]) & (c[2] | c[3]));
+        uint64_t both4 = a[0] & a[1] & a[2] & a[3] & c[0] & c[1] & c[2] & c[3];
+
+        return xh & n1ge2 & n2ge2 & ~both4;
+    }
+
+    // Bit i is lut1[key] for the key of the i-th pixel.
+    inline uint64_t thin_lut1(const uint64_t x[8])
+    {
+        return thin_common(x) & ~((x[1] | x[2] | ~x[7]) & x[0]);
+    }
+
+    // Bit i is lut2[key] for the key of the i-th pixel.
+    inline uint64_t thin_lut2(const uint64_t x[8])
+    {
+        return thin_common(x) & ~((x[5] | x[6] | ~x[3]) & x[4]);
+    }
+}
+
+#endif
@@ -35,10 +35,11 @@ along with cvutil; see the file COPYING.  If not, see
 #include "cvutil_bwdist.h"
 
 #include "cvutil.h"
+#include "cvutil_avx512.h"
+#include "cvutil_baseline.h"
 #include "cvutil_matlab_interface.h"
 #include "cvutil_templates.h"
-
-#include <thread>
+#include "cvutil_threadpool.h"
 
 #pragma warning(disable : 4752)
 
@@ -149,14 +150,15 @@ Mat bwdist_helper::bwdist_st_no_avx(Mat m)
     return result;
 }
 
-void horizontal_st_avx(Mat& result, Mat& arrmat, int tid = -1)
+void horizontal_st_avx(Mat& result, Mat& arrmat, int tid = -1, int nthreads = 1)
 {
     int ncol = result.cols, nrow = result.rows, nelements = result.cols * result.rows, k, i = 0, j, p;
+    int rstep = int(result.step1());   // The result may be a view of a larger matrix
     int *v, *a;
     float *z;
     float s = 0;
     int stepsize = 8, mask;
-    int nstart, nend, nthreads = getNumberOfCPUs();
+    int nstart, nend;
     alignas(32) int indices[8];
     alignas(32) float fvals[8];
     
@@ -188,8 +190,8 @@ void horizontal_st_avx(Mat& result, Mat& arrmat, int tid = -1)
 
     ////////////// For row indexing //////////////
     // Check for memory alignment before performing vector operations.
-    tbuf1 = _mm256_set_epi32((7 + nstart) * ncol, (6 + nstart) * ncol, (5 + nstart) * ncol, (4 + nstart) * ncol, (3 + nstart) * ncol, (2 + nstart) * ncol, (1 + nstart) * ncol, nstart * ncol);
-    tbuf2 = _mm256_set1_epi32(stepsize * ncol);
+    tbuf1 = _mm256_set_epi32((7 + nstart) * rstep, (6 + nstart) * rstep, (5 + nstart) * rstep, (4 + nstart) * rstep, (3 + nstart) * rstep, (2 + nstart) * rstep, (1 + nstart) * rstep, nstart * rstep);
+    tbuf2 = _mm256_set1_epi32(stepsize * rstep);
 
     for (i = nstart; i < nend; i += stepsize)
     {
@@ -201,7 +203,7 @@ void horizontal_st_avx(Mat& result, Mat& arrmat, int tid = -1)
         }
         else // Normal code for the last unaligned elements.
             for (p = 0; p < (nend - i); p++)
-                a[i + p] = (i + p) * ncol;
+                a[i + p] = (i + p) * rstep;
     }
 
     //////////////////// Horizontal scan ////////////////////
@@ -434,31 +436,36 @@ void horizontal_st_avx(Mat& result, Mat& arrmat, int tid = -1)
     }
 }
 
-void vertical_st_avx(Mat& result, Mat& arrmat, int tid = -1)
+void vertical_st_avx(Mat& result, Mat& arrmat, int tid = -1, int nthreads = 1)
 {
     int ncol = result.cols, nrow = result.rows, nelements = result.cols * result.rows, k, i = 0, j, p;
     int *v, *a;
-    float *z, *d;
+    float *z, *d, *f;
     float s = 0;
     int stepsize = 8, mask;
-    int nstart, nend, nthreads = getNumberOfCPUs();
+    int nstart, nend;
     alignas(32) int indices[8];
     alignas(32) float fvals[8];
     
-    Mat vmat, zmat, dmat;
+    Mat vmat, zmat, dmat, fmat;
 
     vmat = Mat::zeros(8, max(ncol, nrow), CV_32SC1);
     zmat = Mat::ones(8, max(ncol, nrow) + 1, CV_32FC1);
     dmat = Mat::zeros(8, nrow, CV_32FC1);
 
+    // Row-contiguous scratch buffer holding the current strip of 8
+    // columns. Element (i, p) of the strip is at f[i * 8 + p].
+    fmat = Mat::zeros(8, nrow, CV_32FC1);
+
     float *resultptr = result.ptr<float>();
     v = vmat.ptr<int>();
     z = zmat.ptr<float>();
     d = dmat.ptr<float>();
+    f = fmat.ptr<float>();
     a = arrmat.ptr<int>();
 
     // AVX specific
-    __m256i tbuf1, vk, vofkidx, vofkidx_step, vofk, vj, tzero, tone, vstep, va;
+    __m256i tbuf1, vk, vofkidx, vofkidx_step, vofk, tzero, tone, vstep, va;
     __m256 fbuf, fbuf1, fbuf2, fbuf3, fbuf4, nflt, flt, fzero, zofk;
 
     // Thread management
@@ -483,23 +490,27 @@ void vertical_st_avx(Mat& result, Mat& arrmat, int tid = -1)
     tone = _mm256_set1_epi32(1);
 
     //////////////////// Vertical scan ////////////////////
-    vj = _mm256_set_epi32(7 + nstart, 6 + nstart, 5 + nstart, 4 + nstart, 3 + nstart, 2 + nstart, 1 + nstart, 0 + nstart);
-    vj = _mm256_sub_epi32(vj, vstep);
-
+    // Gathering resultptr[a[v[k]] + j] directly strides a full row per
+    // lane, which misses the cache on large images. Instead, each strip
+    // of 8 columns is copied into the scratch buffer f (one contiguous
+    // load per row), the scan runs on f, which stays in L1/L2 cache,
+    // and the result is written back row by row.
     for (j = nstart; j < nend; j += stepsize)
     {
         if ((j + stepsize) <= nend)
         {
+            for (i = 0; i < nrow; i++)
+                _mm256_storeu_ps(&f[i * stepsize], _mm256_loadu_ps(&resultptr[a[i] + j]));
+
             _mm256_storeu_si256((__m256i *)&v[0], tzero);
             _mm256_storeu_ps(&z[0], nflt);
             _mm256_storeu_ps(&z[stepsize], flt);
             vk = _mm256_set1_epi32(0);
-            vj = _mm256_add_epi32(vj, vstep);
 
             for (i = 1; i < nrow; i++)
             {
-                // Get resultptr[a[i] + j]
-                fbuf = _mm256_loadu_ps(&resultptr[a[i] + j]);
+                // Get f[i][p], i.e., resultptr[a[i] + j + p]
+                fbuf = _mm256_loadu_ps(&f[i * stepsize]);
 
                 // Get v[k]
                 vofkidx = _mm256_mullo_epi32(vk, vstep);
@@ -512,12 +523,10 @@ void vertical_st_avx(Mat& result, Mat& arrmat, int tid = -1)
                 // zofk = _MM_FUNC_I32(_mm256_set_ps, z, vofkidx);
                 zofk = _mm256_i32gather_ps(z, vofkidx, 4);
                 
-                // Get resultptr[a[v[k]] + j]
-                // va = _MM_FUNC_I32(_mm256_set_epi32, a, vofk);
-                va = _mm256_i32gather_epi32(a, vofk, 4);
-                va = _mm256_add_epi32(va, vj);
-                // fbuf1 = _MM_FUNC_I32(_mm256_set_ps, resultptr, va);
-                fbuf1 = _mm256_i32gather_ps(resultptr, va, 4);
+                // Get f[v[k]][p], i.e., resultptr[a[v[k]] + j + p]
+                va = _mm256_slli_epi32(vofk, 3);
+                va = _mm256_add_epi32(va, tbuf1);
+                fbuf1 = _mm256_i32gather_ps(f, va, 4);
                 
                 fbuf4 = _mm256_set1_ps(float(i));
                 fbuf2 = _mm256_cvtepi32_ps(vofk);
@@ -559,12 +568,10 @@ void vertical_st_avx(Mat& result, Mat& arrmat, int tid = -1)
                     // zofk = _MM_FUNC_I32(_mm256_set_ps, z, vofkidx);
                     zofk = _mm256_i32gather_ps(z, vofkidx, 4);
                     
-                    // Get new resultptr[a[v[k]] + j]
-                    // va = _MM_FUNC_I32(_mm256_set_epi32, a, vofk);
-                    va = _mm256_i32gather_epi32(a, vofk, 4);
-                    va = _mm256_add_epi32(va, vj);
-                    // fbuf1 = _MM_FUNC_I32(_mm256_set_ps, resultptr, va);
-                    fbuf1 = _mm256_i32gather_ps(resultptr, va, 4);
+                    // Get new f[v[k]][p]
+                    va = _mm256_slli_epi32(vofk, 3);
+                    va = _mm256_add_epi32(va, tbuf1);
+                    fbuf1 = _mm256_i32gather_ps(f, va, 4);
                     
                     fbuf2 = _mm256_cvtepi32_ps(vofk);
                     fbuf1 = _mm256_sub_ps(fbuf, fbuf1);             // resultptr[a[i] + j] - resultptr[a[v[k]] + j]
@@ -644,12 +651,10 @@ void vertical_st_avx(Mat& result, Mat& arrmat, int tid = -1)
                 // vofk = _MM_FUNC_I32(_mm256_set_epi32, v, vofkidx);
                 vofk = _mm256_i32gather_epi32(v, vofkidx, 4);
                 
-                // Get new resultptr[a[v[k]] + j]
-                // va = _MM_FUNC_I32(_mm256_set_epi32, a, vofk);
-                va = _mm256_i32gather_epi32(a, vofk, 4);
-                va = _mm256_add_epi32(va, vj);
-                // fbuf1 = _MM_FUNC_I32(_mm256_set_ps, resultptr, va);
-                fbuf1 = _mm256_i32gather_ps(resultptr, va, 4);
+                // Get new f[v[k]][p]
+                va = _mm256_slli_epi32(vofk, 3);
+                va = _mm256_add_epi32(va, tbuf1);
+                fbuf1 = _mm256_i32gather_ps(f, va, 4);
                 
                 fbuf2 = _mm256_cvtepi32_ps(vofk);
                 fbuf4 = _mm256_sub_ps(fbuf4, fbuf2);            // Compute (i - v[k])
@@ -712,6 +717,173 @@ void vertical_st_avx(Mat& result, Mat& arrmat, int tid = -1)
     }
 }
 
+#if defined(CVUTIL_AVX512)
+// Scalar scan of row i, used for the rows left over after the 16-row
+// blocks of horizontal_st_avx512.
+static void horizontal_row_scalar(float *resultptr, int *a, int *v, float *z, int ncol, int i)
+{
+    int j, k;
+    float s;
+
+    v[0] = 0;
+    z[0] = -FLT_MAX; z[1] = FLT_MAX;
+    k = 0;
+
+    for (j = 1; j < ncol; j++)
+    {
+        s = (resultptr[a[i] + j] - resultptr[a[i] + v[k]] +
+            (j * j - v[k] * v[k])) / float(2 * (j - v[k]));
+
+        while (s <= z[k])
+        {
+            k--;
+            s = (resultptr[a[i] + j] - resultptr[a[i] + v[k]] +
+                (j * j - v[k] * v[k])) / float(2 * (j - v[k]));
+        }
+
+        k++;
+        v[k] = j;
+        z[k] = s;
+        z[k + 1] = FLT_MAX;
+    }
+
+    for (j = 0, k = 0; j < ncol; j++)
+    {
+        while (z[k + 1] < j)
+            k++;
+
+        resultptr[a[i] + j] = (j - v[k]) * (j - v[k]) + resultptr[a[i] + v[k]];
+    }
+}
+
+// Scalar scan of column j, used for the columns left over after the
+// 16-column strips of vertical_st_avx512.
+static void vertical_col_scalar(float *resultptr, int *a, int *v, float *z, float *d, int nrow, int j)
+{
+    int i, k;
+    float s;
+
+    v[0] = 0;
+    z[0] = -FLT_MAX; z[1] = FLT_MAX;
+    k = 0;
+
+    for (i = 1; i < nrow; i++)
+    {
+        s = (resultptr[a[i] + j] - resultptr[a[v[k]] + j] +
+            (i * i - v[k] * v[k])) / float(2 * (i - v[k]));
+
+        while (s <= z[k])
+        {
+            k--;
+            s = (resultptr[a[i] + j] - resultptr[a[v[k]] + j] +
+                (i * i - v[k] * v[k])) / float(2 * (i - v[k]));
+        }
+
+        k++;
+        v[k] = i;
+        z[k] = s;
+        z[k + 1] = FLT_MAX;
+    }
+
+    for (i = 0, k = 0; i < nrow; i++)
+    {
+        while (z[k + 1] < i)
+            k++;
+
+        d[i] = ((i - v[k]) * (i - v[k]) + resultptr[a[v[k]] + j]);
+    }
+
+    for (i = 0; i < nrow; i++)
+        resultptr[a[i] + j] = (d[i] >= 2) ? sqrtf(d[i]) : d[i];
+}
+
+// AVX-512 variant of horizontal_st_avx. The 16-row blocks are scanned
+// by avx512_helper::bwdist_rows(), and the remaining rows by the
+// scalar code.
+void horizontal_st_avx512(Mat& result, Mat& arrmat, int tid = -1, int nthreads = 1)
+{
+    int ncol = result.cols, nrow = result.rows, i, p;
+    int rstep = int(result.step1());
+    int *v, *a;
+    float *z;
+    int nstart, nend;
+
+    Mat vmat, zmat;
+
+    vmat = Mat::zeros(16, max(ncol, nrow), CV_32SC1);
+    zmat = Mat::ones(16, max(ncol, nrow) + 1, CV_32FC1);
+
+    float *resultptr = result.ptr<float>();
+    v = vmat.ptr<int>();
+    z = zmat.ptr<float>();
+    a = arrmat.ptr<int>();
+
+    // Thread management
+    if (tid == -1)
+    {
+        nstart = 0;
+        nend = nrow;
+    }
+    else
+    {
+        nstart = tid * nrow / nthreads;
+        nend = (tid == (nthreads - 1)) ? (nrow) : ((tid + 1) * nrow / nthreads);
+    }
+
+    for (i = nstart; i < nend; i++)
+        a[i] = i * rstep;
+
+    i = avx512_helper::bwdist_rows(resultptr, a, v, z, ncol, nstart, nend);
+
+    // Normal code for the last rows.
+    for (p = i; p < nend; p++)
+        horizontal_row_scalar(resultptr, a, v, z, ncol, p);
+}
+
+// AVX-512 variant of vertical_st_avx. The strips of 16 columns are
+// scanned by avx512_helper::bwdist_cols(), and the remaining columns
+// by the scalar code.
+void vertical_st_avx512(Mat& result, Mat& arrmat, int tid = -1, int nthreads = 1)
+{
+    int ncol = result.cols, nrow = result.rows, j, p;
+    int *v, *a;
+    float *z, *d, *f;
+    int nstart, nend;
+
+    Mat vmat, zmat, dmat, fmat;
+
+    vmat = Mat::zeros(16, max(ncol, nrow), CV_32SC1);
+    zmat = Mat::ones(16, max(ncol, nrow) + 1, CV_32FC1);
+    dmat = Mat::zeros(16, nrow, CV_32FC1);
+    fmat = Mat::zeros(16, nrow, CV_32FC1);
+
+    float *resultptr = result.ptr<float>();
+    v = vmat.ptr<int>();
+    z = zmat.ptr<float>();
+    d = dmat.ptr<float>();
+    f = fmat.ptr<float>();
+    a = arrmat.ptr<int>();
+
+    // Thread management
+    if (tid == -1)
+    {
+        nstart = 0;
+        nend = ncol;
+    }
+    else
+    {
+        nstart = tid * ncol / nthreads;
+        nend = (tid == (nthreads - 1)) ? (ncol) : ((tid + 1) * ncol / nthreads);
+    }
+
+    j = avx512_helper::bwdist_cols(resultptr, a, v, z, d, f, nrow, nstart, nend);
+
+    // Normal code for the last columns.
+    for (p = j; p < nend; p++)
+        vertical_col_scalar(resultptr, a, v, z, d, nrow, p);
+}
+#endif
+
 Mat bwdist_helper::bwdist_st_avx(Mat m)
 {
     Mat result = (m != 0);
@@ -732,33 +904,96 @@ Mat bwdist_helper::bwdist_st_avx(Mat m)
     return result;
 }
 
+// Sets the background pixels of the distance map to 0 and the others
+// to FLT_MAX, in a single pass over m.
+static void init_distance(Mat m, Mat& result)
+{
+    for (int i = 0; i < m.rows; i++)
+    {
+        const uchar *mrow = m.ptr<uchar>(i);
+        float *rrow = result.ptr<float>(i);
+
+        for (int j = 0; j < m.cols; j++)
+            rrow[j] = (mrow[j] != 0) ? FLT_MAX : 0.0f;
+    }
+}
+
 Mat bwdist_helper::bwdist_mt(Mat m)
 {
-    Mat result = (m != 0);
-    result.convertTo(result, CV_32FC1);
-    result /= 255.0;
-    result *= FLT_MAX;
+    Mat result(m.size(), CV_32FC1);
+    bwdist_mt(m, result);
+    return result;
+}
+
+void bwdist_helper::bwdist_mt(Mat m, Mat& result)
+{
+    init_distance(m, result);
     Mat arrmat;
-    int ncol = result.cols, nrow = result.rows;
-    int nthreads = getNumberOfCPUs();
+    int nrow = result.rows;
 
     arrmat = Mat::ones(1, nrow, CV_32SC1);
 
-    std::thread *threads = new std::thread[nthreads];
+#if defined(CVUTIL_AVX512)
+    // Use the 16 lane kernels if the CPU supports AVX-512.
+    if (checkHardwareSupport(CPU_AVX_512F))
+    {
+        threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
+        {
+            horizontal_st_avx512(result, arrmat, tid, nthreads);
+            barrier.wait();
+            vertical_st_avx512(result, arrmat, tid, nthreads);
+        });
 
-    for (int tid = 0; tid < nthreads; tid++)
-        threads[tid] = std::thread(horizontal_st_avx, std::ref(result), std::ref(arrmat), tid);
+        return;
+    }
+#endif
 
-    for (int tid = 0; tid < nthreads; tid++)
-        threads[tid].join();
+    // The vertical scan needs the row offsets and the results of
+    // the horizontal scan from all the workers.
+    threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
+    {
+        horizontal_st_avx(result, arrmat, tid, nthreads);
+        barrier.wait();
+        vertical_st_avx(result, arrmat, tid, nthreads);
+    });
+}
 
-    for (int tid = 0; tid < nthreads; tid++)
-        threads[tid] = std::thread(vertical_st_avx, std::ref(result), std::ref(arrmat), tid);
+// Multithreaded implementation for CPUs without AVX2. The rows are
+// split across the workers for the horizontal scan and the columns for
+// the vertical scan. The scans are in cvutil_baseline.cpp, which is
+// built without the AVX2/FMA flags.
+Mat bwdist_helper::bwdist_mt_no_avx(Mat m)
+{
+    Mat result(m.size(), CV_32FC1);
+    bwdist_mt_no_avx(m, result);
+    return result;
+}
 
-    for (int tid = 0; tid < nthreads; tid++)
-        threads[tid].join();
+void bwdist_helper::bwdist_mt_no_avx(Mat m, Mat& result)
+{
+    init_distance(m, result);
+    int ncol = result.cols, nrow = result.rows;
+    size_t rstep = result.step1();
+    float *resultptr = result.ptr<float>();
 
-    delete[] threads;
+    threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
+    {
+        int n = max(ncol, nrow), nstart, nend;
+        std::vector<int> v(n);
+        std::vector<float> z(n + 1), d(n), f(size_t(baseline_helper::bwdist_strip) * nrow);
 
-    return result;
+        // Horizontal scan
+        nstart = tid * nrow / nthreads;
+        nend = (tid == (nthreads - 1)) ? (nrow) : ((tid + 1) * nrow / nthreads);
+
+        baseline_helper::bwdist_rows(resultptr, rstep, ncol, nstart, nend, v.data(), z.data(), d.data());
+
+        barrier.wait();
+
+        // Vertical scan
+        nstart = tid * ncol / nthreads;
+        nend = (tid == (nthreads - 1)) ? (ncol) : ((tid + 1) * ncol / nthreads);
+
+        baseline_helper::bwdist_cols(resultptr, rstep, nrow, nstart, nend, v.data(), z.data(), d.data(), f.data());
+    });
 }
@@ -28,8 +28,8 @@ along with cvutil; see the file COPYING.  If not, see
 
 #pragma once
 
-#ifndef CVUTIL_BWTHIN_H
-#define CVUTIL_BWTHIN_H
+#ifndef CVUTIL_BWDIST_H
+#define CVUTIL_BWDIST_H
 
 #include "stdproto.h"
 
@@ -38,6 +38,13 @@ namespace bwdist_helper
     cv::Mat bwdist_st_no_avx(cv::Mat inputc);
     cv::Mat bwdist_st_avx(cv::Mat inputc);
     cv::Mat bwdist_mt(cv::Mat inputc);
+    cv::Mat bwdist_mt_no_avx(cv::Mat inputc);
+
+    // Same as above, but write the distance map to result, which must
+    // be a CV_32FC1 matrix of the size of inputc. result may be a view
+    // of a larger matrix, e.g., the interior of a padded buffer.
+    void bwdist_mt(cv::Mat inputc, cv::Mat& result);
+    void bwdist_mt_no_avx(cv::Mat inputc, cv::Mat& result);
 }
 
 #endif
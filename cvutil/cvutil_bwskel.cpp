@@ -30,6 +30,7 @@ along with cvutil; see the file COPYING.  If not, see
 
 #include "cvutil.h"
 #include "cvutil_bwskel.h"
+#include "cvutil_threadpool.h"
 
 #pragma warning(disable : 4752)
 
@@ -582,6 +583,77 @@ public:
     }
 };
 
+// Union-find over the pixels of the ridge map, so that the ridge
+// components can be updated as the steepest ascent paths are drawn
+// instead of labeling the whole image after every pass.
+static int ridge_root(vector<int>& parent, int p)
+{
+    while (parent[p] != p)
+    {
+        parent[p] = parent[parent[p]];
+        p = parent[p];
+    }
+
+    return p;
+}
+
+// Adds the ridge pixels in added to the union-find and rebuilds the
+// components and their labels. The components are numbered in the
+// raster order of their first pixels, and the pixels of a component
+// are in raster order, as returned by getConnectedComponents(). Only
+// the ridge pixels are visited.
+static void update_ridge_components(uchar *resultptr, int *labptr, int cols, vector<int>& parent,
+    vector<int>& pixels, vector<int>& added, vector<vector<int>>& comps)
+{
+    const int N[8] = { 1, -cols + 1, -cols, -cols - 1, -1, cols - 1, cols, cols + 1 };
+    int r1, r2;
+
+    for (int p : added)
+        parent[p] = p;
+
+    for (int p : added)
+    {
+        for (int n = 0; n < 8; n++)
+        {
+            if (resultptr[p + N[n]] != 255)
+                continue;
+
+            r1 = ridge_root(parent, p);
+            r2 = ridge_root(parent, p + N[n]);
+
+            if (r1 < r2)
+                parent[r2] = r1;
+            else if (r2 < r1)
+                parent[r1] = r2;
+        }
+    }
+
+    size_t nold = pixels.size();
+    sort(added.begin(), added.end());
+    pixels.insert(pixels.end(), added.begin(), added.end());
+    inplace_merge(pixels.begin(), pixels.begin() + nold, pixels.end());
+    added.clear();
+
+    for (int p : pixels)
+        labptr[p] = 0;
+
+    comps.clear();
+
+    for (int p : pixels)
+    {
+        r1 = ridge_root(parent, p);
+
+        if (labptr[r1] == 0)
+        {
+            comps.emplace_back();
+            labptr[r1] = int(comps.size());
+        }
+
+        labptr[p] = labptr[r1];
+        comps[labptr[p] - 1].push_back(p);
+    }
+}
+
 Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
 {
     pair<Mat, Mat> nzpixels = find(dist, FindType::Indices);
@@ -599,27 +671,32 @@ Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
     float P;
     vector<float> V = { 0,0,0,0,0,0,0,0 };
     float maxv;
-    int nc;
     int loc, maxvcount, pt, p1, p2, p3, p4, newp1, newp2, newp3, newp4, nelements = dist.cols * dist.rows - 1;
     bool IsComplete;
 
-    int nstart = 0;
-    int nend = npixels;
-    int thpt = 0;
-
     location *ploc = new location(&inputc, &dist, &result);
     
-    // Ridge detection
-    for (int i = nstart; i < nend; i++)
+    // Ridge detection. isridge() only reads the input image and the
+    // distance map, so the pixels are split among the workers, each
+    // with its own location cursor.
+    threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
     {
-        thpt = nzpixelsptr[i];
-        ploc->setpt(thpt);
+        location tloc(&inputc, &dist, &result);
+        int nstart = (tid * npixels) / nthreads;
+        int nend = (tid == (nthreads - 1)) ? npixels : ((tid + 1) * npixels) / nthreads;
+        int thpt = 0;
 
-        if (ploc->isridge())
+        for (int i = nstart; i < nend; i++)
         {
-            resultptr[thpt] = 255;
+            thpt = nzpixelsptr[i];
+            tloc.setpt(thpt);
+
+            if (tloc.isridge())
+            {
+                resultptr[thpt] = 255;
+            }
         }
-    }
+    });
 
     //toc();
     //system("pause");
@@ -631,11 +708,38 @@ Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
     // ridges, we can perform steepest ascent on the distance map to
     // connect them to the final skeleton.
 
-    // First to find the connected components on ridge map.
-    unordered_map<int, int> endptdict;
-    endptdict.reserve(10000);
+    // Marks the end points whose steepest ascent is completed. This is
+    // a byte per pixel rather than a hash map, as every ridge pixel is
+    // looked up in each pass.
+    vector<uchar> endptdict(dist.total(), 0);
 
+    // First to find the connected components on ridge map.
     auto ridgecomps = getConnectedComponents(result, lab);
+
+    // The ridge pixels in raster order, their union-find parents and
+    // the pixels added to the ridge map during the current pass.
+    vector<int> ridgeparent(dist.total(), -1);
+    vector<int> ridgepixels, newridge;
+
+    for (auto& comp : ridgecomps)
+    {
+        for (int p : comp)
+        {
+            ridgeparent[p] = comp[0];
+            ridgepixels.push_back(p);
+        }
+    }
+
+    sort(ridgepixels.begin(), ridgepixels.end());
+
+    auto setridge = [&](int p)
+    {
+        if (resultptr[p] != 255)
+        {
+            resultptr[p] = 255;
+            newridge.push_back(p);
+        }
+    };
     size_t prevcomps = 0, prevendpts = 0, cendpts = 0;
     int incomps = connectedComponents(inputc, ilab, 8, CV_32S);
     vector<int> maxcompsize(incomps);
@@ -657,25 +761,55 @@ Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
         vector<bool> isemptyridge;
         ridgeendpts.resize(ridgecomps.size());
         isemptyridge.resize(ridgecomps.size());
-        float nrv1 = -1.0f, nrv2 = -1.0f, Rsum;
-        bool nearstate = false, isendpt = false;
-        int neighborsum = 0;
-        
-        for (int i = 0; i < ridgecomps.size(); i++)
+        float Rsum;
+
+        // The end-point test only reads the maps, so the ridge pixels of
+        // all the components are split evenly among the workers (a single
+        // component may hold most of the pixels). The end-points found by
+        // the workers are merged in order, so that ridgeendpts is the
+        // same as in a serial scan.
+        vector<size_t> compoffsets(ridgecomps.size() + 1, 0);
+        vector<vector<pair<int, int>>> workerendpts;
+
+        for (size_t i = 0; i < ridgecomps.size(); i++)
+            compoffsets[i + 1] = compoffsets[i] + ridgecomps[i].size();
+
+        threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
         {
-            for (int pt : ridgecomps[i])
+            if (tid == 0)
+                workerendpts.resize(nthreads);
+            barrier.wait();
+
+            location tloc(&inputc, &dist, &result);
+            vector<pair<int, int>>& found = workerendpts[tid];
+            size_t ntotal = compoffsets.back();
+            size_t nstart = (tid * ntotal) / nthreads;
+            size_t nend = (tid == (nthreads - 1)) ? ntotal : ((tid + 1) * ntotal) / nthreads;
+            float P = 0.0f, nrv1 = -1.0f, nrv2 = -1.0f;
+            bool isendpt = false;
+            int neighborsum = 0, nc = 0;
+
+            // The component holding the first pixel of the range
+            int i = int(upper_bound(compoffsets.begin(), compoffsets.end(), nstart) - compoffsets.begin()) - 1;
+
+            for (size_t k = nstart; k < nend; k++)
             {
+                while (k >= compoffsets[i + 1])
+                    i++;
+
+                int pt = ridgecomps[i][k - compoffsets[i]];
+
                 if (endptdict[pt] == 1)
                     continue;
 
-                ploc->setpt(pt);
-                isendpt = ploc->isridgeendpt();
-                neighborsum = ploc->getridgeneighborsum();
+                tloc.setpt(pt);
+                isendpt = tloc.isridgeendpt();
+                neighborsum = tloc.getridgeneighborsum();
 
                 // To check and skip if the point is not an end point.
                 if (isendpt || neighborsum == 2)
                 {
-                    P = ploc->distval();
+                    P = tloc.distval();
                     nrv1 = -1.0f;
                     nrv2 = -1.0f;
 
@@ -685,19 +819,19 @@ Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
                         t2 = (n + 7) % 8; // Cyclic for n - 1
                         //temp = ((n % 2) == 0) ? 1.0f : sqrtf(2.0f);
 
-                        if (ploc->ridgeval(n) == 255)
+                        if (tloc.ridgeval(n) == 255)
                         {
-                            if (nrv1 < (ploc->distval(n)))
-                                nrv1 = (ploc->distval(n));
+                            if (nrv1 < (tloc.distval(n)))
+                                nrv1 = (tloc.distval(n));
                         }
                         else
                         {
-                            //if (ploc->isridgeendpt() || ploc->isisolatedneighbor(n))
+                            //if (tloc.isridgeendpt() || tloc.isisolatedneighbor(n))
                             //{
-                                if (ploc->ridgeval(t1) == 0 &&
-                                    ploc->ridgeval(t2) == 0 &&
-                                    nrv2 < (ploc->distval(n)))
-                                    nrv2 = (ploc->distval(n));
+                                if (tloc.ridgeval(t1) == 0 &&
+                                    tloc.ridgeval(t2) == 0 &&
+                                    nrv2 < (tloc.distval(n)))
+                                    nrv2 = (tloc.distval(n));
                             //}
                         }
                     }
@@ -717,14 +851,13 @@ Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
                 if (isendpt)
                 {
                     // Check for (4 and 8)-connectivity
-                    nc = ploc->getimageconnectivity();
-                    
+                    nc = tloc.getimageconnectivity();
+                
                     // To check if the point is interior point
-                    if (ploc->getimageneighborsum() >= 5 || (neighborsum == 0) ||
+                    if (tloc.getimageneighborsum() >= 5 || (neighborsum == 0) ||
                         ((nc > 1) && neighborsum >= 1 && neighborsum <= 3))
                     {
-                        ridgeendpts[i].push_back(pt);
-                        isemptyridge[i] = false;
+                        found.emplace_back(i, pt);
                     }
                 }
                 else if (neighborsum == 2)
@@ -732,10 +865,18 @@ Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
                     /*if (!((P >= nrv1) && (P <= nrv2)))
                         continue;*/
 
-                    ridgeendpts[i].push_back(pt);
-                    isemptyridge[i] = false;
+                    found.emplace_back(i, pt);
                 }
             }
+        });
+
+        for (auto& found : workerendpts)
+        {
+            for (auto& endpt : found)
+            {
+                ridgeendpts[endpt.first].push_back(endpt.second);
+                isemptyridge[endpt.first] = false;
+            }
         }
         
         for (int i = 0; i < ridgecomps.size(); i++)
@@ -869,14 +1010,14 @@ Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
                     {
                         if (maxv > 2.5f)
                         {
-                            resultptr[pt + locsorig[locv]] = 255;
+                            setridge(pt + locsorig[locv]);
                             labptr[pt + locsorig[locv]] = labptr[pt];
                             ridgeendpts[i].push_back(pt + locsorig[locv]);
                             isemptyridge[i] = true;
                         }
                         else
                         {
-                            resultptr[pt + locsorig[locv]] = 255;
+                            setridge(pt + locsorig[locv]);
                             labptr[pt + locsorig[locv]] = labptr[pt];
                         }
                     }
@@ -1027,7 +1168,7 @@ Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
                                     }
                                     else if (maxv == 1)
                                     {
-                                        resultptr[pt + ploc->nval(loc)] = 255;
+                                        setridge(pt + ploc->nval(loc));
                                     }
                                 }
 
@@ -1232,7 +1373,7 @@ Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
                         p3 = newp2;
                         p4 = newp3;
                         pt = pt + loc;
-                        resultptr[pt] = 255;
+                        setridge(pt);
                         ploc->setpt(pt);
                         newp1 = INT_MIN;
                         newp2 = INT_MIN;
@@ -1244,10 +1385,8 @@ Mat bwskel_helper::bwskel(Mat inputc, Mat dist)
         }
         
         prevcomps = ridgecomps.size();
-        ridgecomps = getConnectedComponents(result, lab);
+        update_ridge_components(resultptr, labptr, dist.cols, ridgeparent, ridgepixels, newridge, ridgecomps);
         //connectedComponents(result, lab, 8, CV_32S);
-        labptr = lab.ptr<int>();
-        ploc->setlab(lab);
     } while (true); // || nitr <= 1);
     
     // To remove 1-pixel holes in ridges 
@@ -92,86 +92,17 @@ for i in range(256):
 */
 
 #include "cvutil_bwthin.h"
+#include "cvutil_bitimage.h"
+#include "cvutil_rowruns.h"
+#include "cvutil_threadpool.h"
 
-#include <thread>
+#include <bitset>
 
 using namespace std;
 using namespace cv;
 
-#define INDEX(_k) subsptr[nsubcols * (_k)] * datacols + subsptr[nsubcols * (_k) + 1]
-#define _P   data[INDEX(i)]
 #define LUT_KEY  (((__X7) << 7) + ((__X6) << 6) + ((__X5) << 5) + ((__X4) << 4) + ((__X3) << 3) + ((__X2) << 2) + ((__X1) << 1) + __X0)
 
-#define S_ROWV(_k) subsptr[nsubcols * (_k)]
-#define S_COLV(_k) subsptr[nsubcols * (_k) + 1]
-#define S_CURRV(_k) subsptr[nsubcols * (_k) + 2]
-#define S_PREVV(_k) subsptr[nsubcols * (_k) + 3]
-
-#define S_ROW    S_ROWV(i)
-#define S_COL    S_COLV(i)
-#define S_CURR   S_CURRV(i)
-#define S_PREV   S_PREVV(i)
-
-#define DIRECT_ACCESS(_R, _C)   int(data[(_R) * datacols + (_C)] == 255)
-#define INDEX_ACCESS(_idx)      S_PREVV((_idx))
-
-#define SPARSE_ACCESS(ro, co, ishi, _x)                 \
-{                                                       \
-    key = (ro) * datacols + (co);                       \
-    if (ishi)                                           \
-    {                                                   \
-        lo = i;                                         \
-        hi = ((i + datacols + 3) >= nsubrows) ?         \
-              nsubrows - 1 : (i + datacols + 3);        \
-    }                                                   \
-    else                                                \
-    {                                                   \
-        lo = ((i - datacols - 3) < 0) ?                 \
-              0 : (i - datacols - 3);                   \
-        hi = i;                                         \
-    }                                                   \
-    mset = 0;                                           \
-    idx = ULONG_MAX;                                    \
-                                                        \
-    while((indsptr[hi] != indsptr[lo]) &&               \
-          (key > ((unsigned long)indsptr[lo])) &&       \
-          (key < ((unsigned long)indsptr[hi])))         \
-    {                                                   \
-        mid = lo + ((key - indsptr[lo]) *               \
-                 (hi - lo) /                            \
-                 (indsptr[hi] - indsptr[lo]));          \
-        if (((unsigned long)indsptr[mid]) < key)        \
-            lo = mid + 1;                               \
-        else if (key < ((unsigned long)indsptr[mid]))   \
-            hi = mid - 1;                               \
-        else                                            \
-        {                                               \
-            (_x) = subsptr[nsubcols * mid + 3];         \
-            idx = mid;                                  \
-            mset++;                                     \
-            break;                                      \
-        }                                               \
-    }                                                   \
-    if (!mset)                                          \
-    {                                                   \
-        if (key == indsptr[lo])                         \
-        {                                               \
-            (_x) = subsptr[nsubcols * lo + 3];          \
-            idx = lo;                                   \
-        }                                               \
-        else if (key == indsptr[hi])                    \
-        {                                               \
-            (_x) = subsptr[nsubcols * hi + 3];          \
-            idx = hi;                                   \
-        }                                               \
-        else                                            \
-        {                                               \
-            (_x) = 0;                                   \
-            idx = ULONG_MAX;                            \
-        }                                               \
-    }                                                   \
-}
-
 int lut1[256] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0,
     1, 0, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -202,490 +133,360 @@ int lut2[256] = {
     0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
-struct _thread_data
+// Dense engine. Instead of visiting the foreground pixels one at a time
+// and searching for their neighbors in the subscript list, the image is
+// bit-packed and the lut1/lut2 conditions are evaluated as bitwise
+// expressions on 64 pixels at a time (see cvutil_bitimage.h). Each
+// sub-iteration reads one buffer and writes the other, so all pixels
+// see the state at the start of the sub-iteration, as required by the
+// two-subiteration algorithm.
+Mat bwthin_helper::bwthin_dense(Mat inputc)
 {
-    unsigned char *data;
-    int *subsptr;
-    int *indsptr;
-    int datacols;
-    int datarows;
-    int nsubcols;
-    int nsubrows;
-    int prevsum;
-    int currsum;
-    int subitr;
-    int nthreads;
-    int tid;
-    int nstart;
-    int nend;
-};
-
-Mat bwthin_helper::bwthin_st(Mat inputc, Mat subs, Mat inds)
-{
-    int i = 0;
-    unsigned char *data = inputc.ptr<unsigned char>();
+    using namespace bitimage_helper;
 
-    int datacols = inputc.cols;
-    int nsubcols = subs.cols;
-    int nsubrows = subs.rows;
-    int prevsum = 0, currsum = 0, mset = 0;
-    int *subsptr = subs.ptr<int>();
-    int *indsptr = inds.ptr<int>();
-    int __X0, __X1, __X2, __X3, __X4, __X5, __X6, __X7;
+    BitImage bufa(inputc), bufb(inputc.rows, inputc.cols);
+    BitImage *result = &bufa;
+    int nrows = bufa.rows();
+    int nwords = bufa.words();
 
-    unsigned long key = 0, lo = 0, hi = 0, mid = 0, idx = ULONG_MAX;
+    vector<size_t> deleted;
 
-    do
+    threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
     {
-        // Sub-iteration 1
-        for (i = 0; i < nsubrows; i++)
+        if (tid == 0)
+            deleted.assign(nthreads, 0);
+        barrier.wait();
+
+        int rstart = (tid * nrows) / nthreads;
+        int rend = (tid == (nthreads - 1)) ? nrows : ((tid + 1) * nrows) / nthreads;
+        BitImage *in = &bufa, *out = &bufb;
+        uint64_t x[8];
+        int subitr = 0;
+
+        do
         {
-            if (S_CURR == 1)
+            size_t count = 0;
+
+            for (int r = rstart; r < rend; r++)
             {
-                __X0 = DIRECT_ACCESS(S_ROW, S_COL + 1);
-                SPARSE_ACCESS(S_ROW - 1, S_COL, 0, __X2);
-                if (idx != ULONG_MAX)
-                {
-                    int idxval = idx;
-                    if ((idxval < (nsubrows - 1)) && (INDEX(idxval) + 1) == INDEX(idxval + 1))
-                        __X1 = INDEX_ACCESS(idxval + 1);
-                    else
-                        __X1 = 0;
-                    if ((idxval > 0) && (INDEX(idxval) - 1) == INDEX(idxval - 1))
-                        __X3 = INDEX_ACCESS(idxval - 1);
-                    else
-                        __X3 = 0;
-                }
-                else
+                const uint64_t *up = (r > 0) ? in->ptr(r - 1) : nullptr;
+                const uint64_t *mid = in->ptr(r);
+                const uint64_t *down = (r < nrows - 1) ? in->ptr(r + 1) : nullptr;
+                uint64_t *orow = out->ptr(r);
+
+                for (int w = 0; w < nwords; w++)
                 {
-                    SPARSE_ACCESS(S_ROW - 1, S_COL + 1, 0, __X1);
-                    SPARSE_ACCESS(S_ROW - 1, S_COL - 1, 0, __X3);
-                }
+                    uint64_t p = mid[w], del;
 
-                if ((i > 0) && (INDEX(i) - 1) == INDEX(i - 1))
-                    __X4 = INDEX_ACCESS(i - 1);
-                else
-                    __X4 = 0;
-                __X5 = DIRECT_ACCESS(S_ROW + 1, S_COL - 1);
-                __X6 = DIRECT_ACCESS(S_ROW + 1, S_COL);
-                __X7 = DIRECT_ACCESS(S_ROW + 1, S_COL + 1);
+                    if (p == 0)
+                    {
+                        orow[w] = 0;
+                        continue;
+                    }
 
-                if (lut1[LUT_KEY])
-                {
-                    _P = 0;
-                    S_CURR = 0;
+                    neighbors(up, mid, down, w, nwords, x);
+                    del = p & ((subitr == 0) ? thin_lut1(x) : thin_lut2(x));
+                    orow[w] = p & ~del;
+
+                    if (del)
+                        count += bitset<64>(del).count();
                 }
             }
-        }
-
-        for (i = 0; i < nsubrows; i++)
-            S_PREV = S_CURR;
 
-        // Sub-iteration 2
-        for (i = 0; i < nsubrows; i++)
-        {
-            if (S_CURR == 1)
+            // The counts are only published in the second sub-iteration,
+            // so that no worker overwrites them before all the workers
+            // have read them.
+            if (subitr == 1)
+                deleted[tid] = count;
+            barrier.wait();
+            swap(in, out);
+
+            // Stop when the second sub-iteration does not remove any
+            // pixel. Every worker computes the same total.
+            if (subitr == 1)
             {
-                __X0 = DIRECT_ACCESS(S_ROW, S_COL + 1);
-                SPARSE_ACCESS(S_ROW - 1, S_COL, 0, __X2);
-                if (idx != ULONG_MAX)
-                {
-                    int idxval = idx;
-                    if ((idxval < (nsubrows - 1)) && (INDEX(idxval) + 1) == INDEX(idxval + 1))
-                        __X1 = INDEX_ACCESS(idxval + 1);
-                    else
-                        __X1 = 0;
-                    if ((idxval > 0) && (INDEX(idxval) - 1) == INDEX(idxval - 1))
-                        __X3 = INDEX_ACCESS(idxval - 1);
-                    else
-                        __X3 = 0;
-                }
-                else
-                {
-                    SPARSE_ACCESS(S_ROW - 1, S_COL + 1, 0, __X1);
-                    SPARSE_ACCESS(S_ROW - 1, S_COL - 1, 0, __X3);
-                }
+                size_t total = 0;
 
-                if ((i > 0) && (INDEX(i) - 1) == INDEX(i - 1))
-                    __X4 = INDEX_ACCESS(i - 1);
-                else
-                    __X4 = 0;
-                __X5 = DIRECT_ACCESS(S_ROW + 1, S_COL - 1);
-                __X6 = DIRECT_ACCESS(S_ROW + 1, S_COL);
-                __X7 = DIRECT_ACCESS(S_ROW + 1, S_COL + 1);
+                for (int t = 0; t < nthreads; t++)
+                    total += deleted[t];
 
-                if (lut2[LUT_KEY])
-                {
-                    _P = 0;
-                    S_CURR = 0;
-                }
+                if (total == 0)
+                    break;
             }
-        }
 
-        for (i = 0, currsum = 0, prevsum = 0; i < nsubrows; i++)
-        {
-            if (S_PREV)
-                prevsum++;
-            if (S_CURR)
-                currsum++;
-        }
-
-        if (prevsum == currsum)
-            break;
+            subitr ^= 1;
+        } while (1);
 
-        for (int i = 0; i < nsubrows; i++)
-            S_PREV = S_CURR;
-    } while (1);
+        if (tid == 0)
+            result = in;
+    });
 
-    return inputc;
+    return result->toMat();
 }
 
-void bwthin_thread_apply_lut(void *_pdata)
+// Active-frontier engine. After the first few iterations only a thin
+// layer of pixels changes, so the words of the bit-packed image are
+// evaluated only if a pixel in their 8-neighborhood was deleted since
+// the last sub-iteration that used the same table. The other words
+// would give the same result as in their last evaluation, so the
+// output is the same as that of bwthin_dense().
+//
+// Each sub-iteration first computes the deletions of all the candidate
+// words (in parallel) and only then applies them, so all pixels see the
+// state at the start of the sub-iteration.
+Mat bwthin_helper::bwthin_frontier(Mat inputc)
 {
-    _thread_data pdata = (*(_thread_data *)_pdata);
-    int i = 0;
-    int nstart = pdata.nstart;
-    int nend2 = pdata.nend;
-    int nend1 = nend2 - pdata.datarows - 2;
-    int nend0 = nstart + pdata.datarows + 2;
-    int *subsptr = pdata.subsptr;
-    int *indsptr = pdata.indsptr;
-    unsigned char *data = pdata.data;
-    int nsubcols = pdata.nsubcols;
-    int nsubrows = pdata.nsubrows;
-    int datacols = pdata.datacols;
-    int __X0, __X1, __X2, __X3, __X4, __X5, __X6, __X7, mset = 0;
-    unsigned long key = 0, lo = 0, hi = 0, mid = 0, idx = ULONG_MAX;
-
-    if (pdata.subitr == 0)
+    using namespace bitimage_helper;
+
+    BitImage img(inputc);
+    int nrows = img.rows();
+    int nwords = img.words();
+    size_t nslots = size_t(nrows) * nwords;
+
+    // Candidate words for the two sub-iterations, as r * nwords + w,
+    // and flags to keep each word at most once in a list.
+    vector<int> cand[2];
+    vector<uchar> queued[2];
+    vector<vector<pair<int, uint64_t>>> deletions;
+
+    for (int s = 0; s < 2; s++)
     {
-        for (i = nstart; i < nend1; i++)
-        {
-            if (S_CURR == 1)
-            {
-                __X0 = DIRECT_ACCESS(S_ROW, S_COL + 1);
-                SPARSE_ACCESS(S_ROW - 1, S_COL, 0, __X2);
-                if (idx != ULONG_MAX)
-                {
-                    int idxval = idx;
-                    if ((idxval < (nsubrows - 1)) && (INDEX(idxval) + 1) == INDEX(idxval + 1))
-                        __X1 = INDEX_ACCESS(idxval + 1);
-                    else
-                        SPARSE_ACCESS(S_ROW - 1, S_COL + 1, 0, __X1);
-                    if ((idxval > 0) && (INDEX(idxval) - 1) == INDEX(idxval - 1))
-                        __X3 = INDEX_ACCESS(idxval - 1);
-                    else
-                        SPARSE_ACCESS(S_ROW - 1, S_COL - 1, 0, __X3);
-                }
-                else
-                {
-                    SPARSE_ACCESS(S_ROW - 1, S_COL + 1, 0, __X1);
-                    SPARSE_ACCESS(S_ROW - 1, S_COL - 1, 0, __X3);
-                }
+        queued[s].assign(nslots, 0);
+        cand[s].reserve(nslots);
+    }
 
-                if ((i > 0) && (INDEX(i) - 1) == INDEX(i - 1))
-                    __X4 = INDEX_ACCESS(i - 1);
-                else
-                    SPARSE_ACCESS(S_ROW, S_COL - 1, 0, __X4);
-                __X5 = DIRECT_ACCESS(S_ROW + 1, S_COL - 1);
-                __X6 = DIRECT_ACCESS(S_ROW + 1, S_COL);
-                __X7 = DIRECT_ACCESS(S_ROW + 1, S_COL + 1);
+    for (int r = 0; r < nrows; r++)
+    {
+        const uint64_t *row = img.ptr(r);
 
-                if (lut1[LUT_KEY])
+        for (int w = 0; w < nwords; w++)
+            if (row[w])
+                for (int s = 0; s < 2; s++)
                 {
-                    _P = 0;
-                    S_CURR = 0;
+                    cand[s].push_back(r * nwords + w);
+                    queued[s][r * nwords + w] = 1;
                 }
-            }
-        }
+    }
 
-        for (; i < nend2; i++)
-        {
-            if (S_CURR == 1)
+    auto enqueue = [&](int r, int w)
+    {
+        if (r < 0 || r >= nrows || w < 0 || w >= nwords || img.ptr(r)[w] == 0)
+            return;
+
+        int idx = r * nwords + w;
+
+        for (int s = 0; s < 2; s++)
+            if (!queued[s][idx])
             {
-                if ((i < (nsubrows - 1)) && (INDEX(i) + 1) == INDEX(i + 1))
-                    __X0 = INDEX_ACCESS(i + 1);
-                else
-                    SPARSE_ACCESS(S_ROW, S_COL + 1, 1, __X0);
-                SPARSE_ACCESS(S_ROW - 1, S_COL, 0, __X2);
-                if (idx != ULONG_MAX)
-                {
-                    int idxval = idx;
-                    if ((idxval < (nsubrows - 1)) && (INDEX(idxval) + 1) == INDEX(idxval + 1))
-                        __X1 = INDEX_ACCESS(idxval + 1);
-                    else
-                        SPARSE_ACCESS(S_ROW - 1, S_COL + 1, 0, __X1);
-                    if ((idxval > 0) && (INDEX(idxval) - 1) == INDEX(idxval - 1))
-                        __X3 = INDEX_ACCESS(idxval - 1);
-                    else
-                        SPARSE_ACCESS(S_ROW - 1, S_COL - 1, 0, __X3);
-                }
-                else
-                {
-                    SPARSE_ACCESS(S_ROW - 1, S_COL + 1, 0, __X1);
-                    SPARSE_ACCESS(S_ROW - 1, S_COL - 1, 0, __X3);
-                }
-                
-                if ((i > 0) && (INDEX(i) - 1) == INDEX(i - 1))
-                    __X4 = INDEX_ACCESS(i - 1);
-                else
-                    SPARSE_ACCESS(S_ROW, S_COL - 1, 0, __X4);
-                SPARSE_ACCESS(S_ROW + 1, S_COL, 1, __X6);
-                if (idx != ULONG_MAX)
-                {
-                    int idxval = idx;
-                    if ((idxval < (nsubrows - 1)) && (INDEX(idxval) + 1) == INDEX(idxval + 1))
-                        __X7 = INDEX_ACCESS(idxval + 1);
-                    else
-                        SPARSE_ACCESS(S_ROW + 1, S_COL + 1, 1, __X7);
-                    if ((idxval > 0) && (INDEX(idxval) - 1) == INDEX(idxval - 1))
-                        __X5 = INDEX_ACCESS(idxval - 1);
-                    else
-                        SPARSE_ACCESS(S_ROW + 1, S_COL - 1, 1, __X5);
-                }
-                else
-                {
-                    SPARSE_ACCESS(S_ROW + 1, S_COL - 1, 1, __X5);
-                    SPARSE_ACCESS(S_ROW + 1, S_COL + 1, 1, __X7);
-                }
-                
-                if (lut1[LUT_KEY])
-                {
-                    _P = 0;
-                    S_CURR = 0;
-                }
+                queued[s][idx] = 1;
+                cand[s].push_back(idx);
             }
-        }
-    }
-    else
+    };
+
+    threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
     {
-        for (i = nstart; i < nend1; i++)
+        if (tid == 0)
+            deletions.resize(nthreads);
+        barrier.wait();
+
+        vector<pair<int, uint64_t>>& mydel = deletions[tid];
+        uint64_t x[8];
+        int subitr = 0;
+
+        do
         {
-            if (S_CURR == 1)
+            const vector<int>& list = cand[subitr];
+            int n = int(list.size());
+            int nstart = (tid * n) / nthreads;
+            int nend = (tid == (nthreads - 1)) ? n : ((tid + 1) * n) / nthreads;
+
+            mydel.clear();
+
+            for (int i = nstart; i < nend; i++)
             {
-                __X0 = DIRECT_ACCESS(S_ROW, S_COL + 1);
-                SPARSE_ACCESS(S_ROW - 1, S_COL, 0, __X2);
-                if (idx != ULONG_MAX)
-                {
-                    int idxval = idx;
-                    if ((idxval < (nsubrows - 1)) && (INDEX(idxval) + 1) == INDEX(idxval + 1))
-                        __X1 = INDEX_ACCESS(idxval + 1);
-                    else
-                        SPARSE_ACCESS(S_ROW - 1, S_COL + 1, 0, __X1);
-                    if ((idxval > 0) && (INDEX(idxval) - 1) == INDEX(idxval - 1))
-                        __X3 = INDEX_ACCESS(idxval - 1);
-                    else
-                        SPARSE_ACCESS(S_ROW - 1, S_COL - 1, 0, __X3);
-                }
-                else
-                {
-                    SPARSE_ACCESS(S_ROW - 1, S_COL + 1, 0, __X1);
-                    SPARSE_ACCESS(S_ROW - 1, S_COL - 1, 0, __X3);
-                }
+                int r = list[i] / nwords, w = list[i] % nwords;
+                const uint64_t *up = (r > 0) ? img.ptr(r - 1) : nullptr;
+                const uint64_t *mid = img.ptr(r);
+                const uint64_t *down = (r < nrows - 1) ? img.ptr(r + 1) : nullptr;
 
-                if ((i > 0) && (INDEX(i) - 1) == INDEX(i - 1))
-                    __X4 = INDEX_ACCESS(i - 1);
-                else
-                    SPARSE_ACCESS(S_ROW, S_COL - 1, 0, __X4);
-                __X5 = DIRECT_ACCESS(S_ROW + 1, S_COL - 1);
-                __X6 = DIRECT_ACCESS(S_ROW + 1, S_COL);
-                __X7 = DIRECT_ACCESS(S_ROW + 1, S_COL + 1);
+                neighbors(up, mid, down, w, nwords, x);
 
-                if (lut2[LUT_KEY])
-                {
-                    _P = 0;
-                    S_CURR = 0;
-                }
+                uint64_t del = mid[w] & ((subitr == 0) ? thin_lut1(x) : thin_lut2(x));
+
+                if (del)
+                    mydel.push_back(make_pair(list[i], del));
             }
-        }
+            barrier.wait();
 
-        for (; i < nend2; i++)
-        {
-            if (S_CURR == 1)
+            // Apply the deletions and queue the words around them.
+            if (tid == 0)
             {
-                if ((i < (nsubrows - 1)) && (INDEX(i) + 1) == INDEX(i + 1))
-                    __X0 = INDEX_ACCESS(i + 1);
-                else
-                    SPARSE_ACCESS(S_ROW, S_COL + 1, 1, __X0);
-                SPARSE_ACCESS(S_ROW - 1, S_COL, 0, __X2);
-                if (idx != ULONG_MAX)
-                {
-                    int idxval = idx;
-                    if ((idxval < (nsubrows - 1)) && (INDEX(idxval) + 1) == INDEX(idxval + 1))
-                        __X1 = INDEX_ACCESS(idxval + 1);
-                    else
-                        SPARSE_ACCESS(S_ROW - 1, S_COL + 1, 0, __X1);
-                    if ((idxval > 0) && (INDEX(idxval) - 1) == INDEX(idxval - 1))
-                        __X3 = INDEX_ACCESS(idxval - 1);
-                    else
-                        SPARSE_ACCESS(S_ROW - 1, S_COL - 1, 0, __X3);
-                }
-                else
-                {
-                    SPARSE_ACCESS(S_ROW - 1, S_COL + 1, 0, __X1);
-                    SPARSE_ACCESS(S_ROW - 1, S_COL - 1, 0, __X3);
-                }
+                for (int i : cand[subitr])
+                    queued[subitr][i] = 0;
+                cand[subitr].clear();
+
+                for (auto& dlist : deletions)
+                    for (auto& d : dlist)
+                        img.ptr(d.first / nwords)[d.first % nwords] &= ~d.second;
+
+                for (auto& dlist : deletions)
+                    for (auto& d : dlist)
+                    {
+                        int r = d.first / nwords, w = d.first % nwords;
+                        int wlo = (d.second & 1) ? (w - 1) : w;
+                        int whi = (d.second >> 63) ? (w + 1) : w;
+
+                        for (int dr = -1; dr <= 1; dr++)
+                            for (int dw = wlo; dw <= whi; dw++)
+                                enqueue(r + dr, dw);
+                    }
+            }
+            barrier.wait();
 
-                if ((i > 0) && (INDEX(i) - 1) == INDEX(i - 1))
-                    __X4 = INDEX_ACCESS(i - 1);
-                else
-                    SPARSE_ACCESS(S_ROW, S_COL - 1, 0, __X4);
-                SPARSE_ACCESS(S_ROW + 1, S_COL, 1, __X6);
-                if (idx != ULONG_MAX)
-                {
-                    int idxval = idx;
-                    if ((idxval < (nsubrows - 1)) && (INDEX(idxval) + 1) == INDEX(idxval + 1))
-                        __X7 = INDEX_ACCESS(idxval + 1);
-                    else
-                        SPARSE_ACCESS(S_ROW + 1, S_COL + 1, 1, __X7);
-                    if ((idxval > 0) && (INDEX(idxval) - 1) == INDEX(idxval - 1))
-                        __X5 = INDEX_ACCESS(idxval - 1);
-                    else
-                        SPARSE_ACCESS(S_ROW + 1, S_COL - 1, 1, __X5);
-                }
-                else
-                {
-                    SPARSE_ACCESS(S_ROW + 1, S_COL - 1, 1, __X5);
-                    SPARSE_ACCESS(S_ROW + 1, S_COL + 1, 1, __X7);
-                }
+            // Same stopping rule as bwthin_dense().
+            if (subitr == 1)
+            {
+                bool changed = false;
 
-                if (lut2[LUT_KEY])
-                {
-                    _P = 0;
-                    S_CURR = 0;
-                }
+                for (auto& dlist : deletions)
+                    changed = changed || !dlist.empty();
+
+                if (!changed)
+                    break;
             }
-        }
-    }
-}
+            barrier.wait();
 
-void bwthin_thread_copy_data(void *_pdata)
-{
-    _thread_data pdata = (*(_thread_data *)_pdata);
-    int i = 0;
-    int nstart = pdata.nstart;
-    int nend = pdata.nend;
-    int nsubcols = pdata.nsubcols;
-    int *subsptr = pdata.subsptr;
-
-    for (i = nstart; i < nend; i++)
-        S_PREV = S_CURR;
+            subitr ^= 1;
+        } while (1);
+    });
+
+    return img.toMat();
 }
 
-void bwthin_thread_pixel_sums(void *_pdata)
+
+// Run-based sparse engine. The foreground pixels are kept as row runs
+// (see cvutil_rowruns.h) with one state byte per pixel, so the left and
+// right neighbors of a pixel are the adjacent bytes of its run, and the
+// neighbors in the rows above and below are found with cursors that
+// walk the runs of those rows along with the pixels of the current row,
+// instead of searching the subscript list.
+//
+// Each sub-iteration reads the state at its start (prev) and writes the
+// deletions into curr.
+Mat bwthin_helper::bwthin_runs(Mat inputc, Mat runs, bool serial)
 {
-    _thread_data *pdata = (_thread_data *)_pdata;
-    int i = 0, currsum = 0, prevsum = 0;
-    int nstart = pdata->nstart;
-    int nend = pdata->nend;
-    int nsubcols = pdata->nsubcols;
-    int *subsptr = pdata->subsptr;
-
-    for (i = nstart, currsum = 0, prevsum = 0; i < nend; i++)
-    {
-        if (S_PREV)
-            prevsum++;
-        if (S_CURR)
-            currsum++;
-    }
+    using namespace rowruns_helper;
 
-    pdata->currsum = currsum;
-    pdata->prevsum = prevsum;
-}
+    RunList list(runs, inputc.rows, inputc.cols);
+    int nrows = list.rows;
+    int npixels = list.pixels();
 
-Mat bwthin_helper::bwthin_mt_thread(Mat inputc, Mat subs, Mat inds)
-{
-    int nthreads = getNumberOfCPUs();
-    vector<thread> threads(nthreads);
-    _thread_data *_pdata = new _thread_data[nthreads];
-    unsigned char *data = inputc.ptr<unsigned char>();
-    
-    int i;
-    int prevsum = 0, currsum = 0;
-    int *subsptr = subs.ptr<int>();
-    int *indsptr = inds.ptr<int>();
+    vector<uchar> prev(npixels, 1), curr(npixels, 1);
+    vector<int> rowpixels(nrows + 1);
+    vector<size_t> deleted;
 
-    for (i = 0; i < nthreads; i++)
-    {
-        _pdata[i].currsum = 0;
-        _pdata[i].prevsum = 0;
-        _pdata[i].datacols = inputc.cols;
-        _pdata[i].datarows = inputc.rows;
-        _pdata[i].nsubcols = subs.cols;
-        _pdata[i].nsubrows = subs.rows;
-        _pdata[i].subitr = 0;
-        _pdata[i].tid = i;
-        _pdata[i].nthreads = nthreads;
-        _pdata[i].data = data;
-        _pdata[i].indsptr = indsptr;
-        _pdata[i].subsptr = subsptr;
-
-        if (i == 0)
-            _pdata[i].nstart = 0;
-        else
-            _pdata[i].nstart = _pdata[i - 1].nend;
-
-        if (i == (nthreads - 1))
-            _pdata[i].nend = subs.rows;
-        else
-            _pdata[i].nend = ((i + 1) * subs.rows) / nthreads;
-    }
+    for (int r = 0; r <= nrows; r++)
+        rowpixels[r] = list.offsets[list.rowoffsets[r]];
 
-    do
+    auto task = [&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
     {
-        // Sub-iteration 1
-        for (i = 0; i < nthreads; i++)
-        {
-            _pdata[i].subitr = 0;
-            threads[i] = thread(bwthin_thread_apply_lut, ((void *)&_pdata[i]));
-        }
+        if (tid == 0)
+            deleted.assign(nthreads, 0);
+        barrier.wait();
 
-        for (i = 0; i < nthreads; i++)
-            threads[i].join();
+        // Bands of rows with about the same number of pixels.
+        auto bandrow = [&](int t) -> int
+        {
+            if (t >= nthreads)
+                return nrows;
 
-        // Data copy
-        for (i = 0; i < nthreads; i++)
-            threads[i] = thread(bwthin_thread_copy_data, ((void *)&_pdata[i]));
+            int target = int((int64_t(t) * npixels) / nthreads);
+            return int(lower_bound(rowpixels.begin(), rowpixels.end(), target) - rowpixels.begin());
+        };
 
-        for (i = 0; i < nthreads; i++)
-            threads[i].join();
+        int rstart = min(bandrow(tid), nrows), rend = max(rstart, min(bandrow(tid + 1), nrows));
+        int pstart = rowpixels[rstart], pend = rowpixels[rend];
+        int subitr = 0;
 
-        // Sub-iteration 2
-        for (i = 0; i < nthreads; i++)
+        do
         {
-            _pdata[i].subitr = 1;
-            threads[i] = thread(bwthin_thread_apply_lut, ((void *)&_pdata[i]));
-        }
+            const int *lut = (subitr == 0) ? lut1 : lut2;
+            size_t ndeleted = 0;
+
+            for (int r = rstart; r < rend; r++)
+            {
+                RunCursor up(list, r - 1), down(list, r + 1);
+                int uppos[3], downpos[3];
 
-        for (i = 0; i < nthreads; i++)
-            threads[i].join();
+                for (int j = list.rowoffsets[r]; j < list.rowoffsets[r + 1]; j++)
+                {
+                    int cstart = list.starts[j], cend = list.ends[j];
+
+                    for (int c = cstart, p = list.offsets[j]; c <= cend; c++, p++)
+                    {
+                        if (!prev[p])
+                            continue;
+
+                        up.find3(c, uppos);
+                        down.find3(c, downpos);
+
+                        int __X0 = (c < cend) ? prev[p + 1] : 0;
+                        int __X1 = (uppos[2] >= 0) ? prev[uppos[2]] : 0;
+                        int __X2 = (uppos[1] >= 0) ? prev[uppos[1]] : 0;
+                        int __X3 = (uppos[0] >= 0) ? prev[uppos[0]] : 0;
+                        int __X4 = (c > cstart) ? prev[p - 1] : 0;
+                        int __X5 = (downpos[0] >= 0) ? prev[downpos[0]] : 0;
+                        int __X6 = (downpos[1] >= 0) ? prev[downpos[1]] : 0;
+                        int __X7 = (downpos[2] >= 0) ? prev[downpos[2]] : 0;
+
+                        if (lut[LUT_KEY])
+                        {
+                            curr[p] = 0;
+                            ndeleted++;
+                        }
+                    }
+                }
+            }
+            barrier.wait();
 
-        // Compute pixel sums
-        for (i = 0; i < nthreads; i++)
-            threads[i] = thread(bwthin_thread_pixel_sums, ((void *)&_pdata[i]));
+            copy(curr.begin() + pstart, curr.begin() + pend, prev.begin() + pstart);
+            deleted[tid] = ndeleted;
+            barrier.wait();
 
-        for (i = 0; i < nthreads; i++)
-            threads[i].join();
+            // Same stopping rule as bwthin_dense().
+            if (subitr == 1)
+            {
+                size_t total = 0;
 
-        // Consolidate pixel sums from all threads
-        for (i = 0, prevsum = 0, currsum = 0; i < nthreads; i++)
-        {
-            prevsum += _pdata[i].prevsum;
-            currsum += _pdata[i].currsum;
-        }
+                for (size_t d : deleted)
+                    total += d;
 
-        if (prevsum == currsum)
-            break;
+                if (total == 0)
+                    break;
+            }
+            barrier.wait();
 
-        // Data copy
-        for (i = 0; i < nthreads; i++)
-            threads[i] = thread(bwthin_thread_copy_data, ((void *)&_pdata[i]));
+            subitr ^= 1;
+        } while (1);
 
-        for (i = 0; i < nthreads; i++)
-            threads[i].join();
-    } while (1);
+        // Write the result back into the band of rows.
+        for (int r = rstart; r < rend; r++)
+        {
+            uchar *row = inputc.ptr<uchar>(r);
+
+            for (int j = list.rowoffsets[r]; j < list.rowoffsets[r + 1]; j++)
+                for (int c = list.starts[j], p = list.offsets[j]; c <= list.ends[j]; c++, p++)
+                    row[c] = curr[p] ? 255 : 0;
+        }
+    };
+
+    if (serial)
+    {
+        threadpool_helper::Barrier barrier(1);
+        task(0, 1, barrier);
+    }
+    else
+        threadpool_helper::parallel_run(task);
 
-    delete[] _pdata;
     return inputc;
 }
-
@@ -35,8 +35,19 @@ along with cvutil; see the file COPYING.  If not, see
 
 namespace bwthin_helper
 {
-    cv::Mat bwthin_st(cv::Mat inputc, cv::Mat subs, cv::Mat inds);
-    cv::Mat bwthin_mt_thread(cv::Mat inputc, cv::Mat subs, cv::Mat inds);
+    // Bit-packed engine for dense images. It does not need the
+    // subscripts of the foreground pixels.
+    cv::Mat bwthin_dense(cv::Mat inputc);
+
+    // Bit-packed engine that only revisits the words next to the
+    // pixels deleted in the previous sub-iterations.
+    cv::Mat bwthin_frontier(cv::Mat inputc);
+
+    // Sparse engine that keeps the foreground pixels as row runs, given
+    // by cvutil::find() with FindType::Runs, and looks up the neighbors
+    // of a pixel by walking the runs of the adjacent rows. If serial is
+    // true, the engine runs on the calling thread only.
+    cv::Mat bwthin_runs(cv::Mat inputc, cv::Mat runs, bool serial = false);
 }
 
 #endif
@@ -0,0 +1,445 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_conncomp.cpp
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+// Parallel connected component labeling
+//
+// The image is split into bands of rows, one per worker. Each worker
+// labels its band with a raster scan and a local union-find. The
+// provisional labels of all the bands are then placed in a single
+// union-find, the equivalences across the band seams are merged, and
+// the roots are numbered in raster order. Finally, each worker
+// relabels its band and scatters the pixel indices into the component
+// lists, using per-band offsets so that the lists stay in raster order.
+
+#include "cvutil_conncomp.h"
+#include "cvutil_threadpool.h"
+
+using namespace std;
+using namespace cv;
+
+namespace
+{
+    inline int find_root(int *parent, int k)
+    {
+        while (parent[k] != k)
+        {
+            parent[k] = parent[parent[k]];
+            k = parent[k];
+        }
+
+        return k;
+    }
+
+    // The root of a set is always its smallest label, which is the
+    // label created at the first pixel of the component.
+    inline void merge(int *parent, int a, int b)
+    {
+        a = find_root(parent, a);
+        b = find_root(parent, b);
+
+        if (a < b)
+            parent[b] = a;
+        else if (b < a)
+            parent[a] = b;
+    }
+
+    struct band_data
+    {
+        int rstart;
+        int rend;
+        int base;                    // Global index of the first label of the band
+        vector<int> parent;          // Local union-find
+        vector<int> count;           // Number of pixels of each local label
+        int nroots;
+    };
+}
+
+void conncomp_helper::label_mt(Mat m, Mat& lab, int size, int conn, const ComponentAllocator& alloc, Mat *mask)
+{
+    int nrows = m.rows, ncols = m.cols;
+
+    // The rows are addressed with ptr(), as the label image may be a
+    // caller's ROI, which is kept if its size and type match.
+    lab.create(m.size(), CV_32S);
+
+    if (mask != nullptr)
+        mask->create(m.size(), CV_8UC1);
+
+    vector<band_data> bands;
+    vector<int> gparent, gcount, groot, gfinal, grep, gcursor;
+    vector<int> nsize, outidx, outsize;
+    vector<int *> storage;
+    int ncomp = 0;
+
+    threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
+    {
+        if (tid == 0)
+            bands.resize(nthreads);
+        barrier.wait();
+
+        band_data& band = bands[tid];
+        int r, c, k, l;
+
+        band.rstart = tid * nrows / nthreads;
+        band.rend = (tid == (nthreads - 1)) ? nrows : ((tid + 1) * nrows / nthreads);
+
+        //////////////// Local labeling of the band ////////////////
+        vector<int>& parent = band.parent;
+        vector<int>& count = band.count;
+
+        for (r = band.rstart; r < band.rend; r++)
+        {
+            const uchar *row = m.ptr<uchar>(r);
+            int *lrow = lab.ptr<int>(r);
+            const int *lprev = (r > band.rstart) ? lab.ptr<int>(r - 1) : nullptr;
+
+            for (c = 0; c < ncols; c++)
+            {
+                if (row[c] == 0)
+                {
+                    lrow[c] = 0;
+                    continue;
+                }
+
+                // Local labels are 1-based in lab and 0-based in parent.
+                l = (c > 0) ? lrow[c - 1] : 0;
+
+                if (lprev != nullptr)
+                {
+                    int up[3] = { 0, lprev[c], 0 };
+
+                    if (conn == 8)
+                    {
+                        up[0] = (c > 0) ? lprev[c - 1] : 0;
+                        up[2] = (c < ncols - 1) ? lprev[c + 1] : 0;
+                    }
+
+                    for (k = 0; k < 3; k++)
+                    {
+                        if (up[k] == 0)
+                            continue;
+                        if (l == 0)
+                            l = up[k];
+                        else if (l != up[k])
+                            merge(parent.data(), l - 1, up[k] - 1);
+                    }
+                }
+
+                if (l == 0)
+                {
+                    parent.push_back(int(parent.size()));
+                    count.push_back(0);
+                    l = int(parent.size());
+                }
+
+                lrow[c] = l;
+                count[l - 1]++;
+            }
+        }
+
+        barrier.wait();
+
+        //////////////// Global union-find ////////////////
+        if (tid == 0)
+        {
+            int total = 0;
+
+            for (auto& b : bands)
+            {
+                b.base = total;
+                total += int(b.parent.size());
+            }
+
+            gparent.resize(total);
+            gcount.resize(total);
+            groot.resize(total);
+            gfinal.resize(total);
+        }
+        barrier.wait();
+
+        int base = band.base, nlabels = int(parent.size());
+
+        for (k = 0; k < nlabels; k++)
+        {
+            gparent[base + k] = base + parent[k];
+            gcount[base + k] = count[k];
+        }
+
+        barrier.wait();
+
+        // Merge the labels across the seams. The number of seam pixels
+        // is small, so this is done by a single worker.
+        if (tid == 0)
+        {
+            int above = 0;
+
+            for (int b = 1; b < nthreads; b++)
+            {
+                if (bands[b].rstart == bands[b].rend)
+                    continue;
+
+                // The last non-empty band above this one.
+                for (above = b - 1; above > 0 && bands[above].rstart == bands[above].rend; above--);
+
+                if (bands[above].rstart == bands[above].rend)
+                    continue;
+
+                int *lrow = lab.ptr<int>(bands[b].rstart);
+                int *lprev = lab.ptr<int>(bands[b].rstart - 1);
+                int cbase = bands[b].base, pbase = bands[above].base;
+
+                for (c = 0; c < ncols; c++)
+                {
+                    if (lrow[c] == 0)
+                        continue;
+
+                    for (int dc = (conn == 8 ? -1 : 0); dc <= (conn == 8 ? 1 : 0); dc++)
+                    {
+                        if (c + dc < 0 || c + dc >= ncols || lprev[c + dc] == 0)
+                            continue;
+
+                        merge(gparent.data(), cbase + lrow[c] - 1, pbase + lprev[c + dc] - 1);
+                    }
+                }
+            }
+        }
+        barrier.wait();
+
+        // Flatten the union-find. The roots are read without path
+        // compression, as other workers read the same entries.
+        for (k = base; k < base + nlabels; k++)
+        {
+            l = k;
+            while (gparent[l] != l)
+                l = gparent[l];
+            groot[k] = l;
+        }
+
+        band.nroots = 0;
+        for (k = base; k < base + nlabels; k++)
+            if (groot[k] == k)
+                band.nroots++;
+
+        barrier.wait();
+
+        // Number the roots in raster order.
+        l = 0;
+        for (int b = 0; b < tid; b++)
+            l += bands[b].nroots;
+
+        for (k = base; k < base + nlabels; k++)
+            if (groot[k] == k)
+                gfinal[k] = ++l;
+
+        barrier.wait();
+
+        for (k = base; k < base + nlabels; k++)
+            if (groot[k] != k)
+                gfinal[k] = gfinal[groot[k]];
+
+        barrier.wait();
+
+        //////////////// Component sizes and offsets ////////////////
+        // This is linear in the number of provisional labels, which is
+        // much smaller than the number of pixels.
+        if (tid == 0)
+        {
+            int nrequiredcomp = 0;
+            vector<int> lastband, rep, running;
+
+            for (auto& b : bands)
+                ncomp += b.nroots;
+
+            nsize.assign(ncomp, 0);
+            for (k = 0; k < int(gfinal.size()); k++)
+                nsize[gfinal[k] - 1] += gcount[k];
+
+            outidx.assign(ncomp, -1);
+            for (k = 0; k < ncomp; k++)
+                if (size <= 0 || nsize[k] > size)
+                    outidx[k] = nrequiredcomp++;
+
+            // The pixel lists are not needed when only the mask of the
+            // retained components is requested.
+            if (alloc)
+            {
+                outsize.resize(nrequiredcomp);
+                for (k = 0; k < ncomp; k++)
+                    if (outidx[k] >= 0)
+                        outsize[outidx[k]] = nsize[k];
+
+                alloc(outsize, storage);
+
+                grep.resize(gfinal.size());
+                gcursor.resize(gfinal.size());
+
+                // The labels of a component within a band share a cursor
+                // (held by the first such label), starting after the pixels
+                // of the component in the previous bands.
+                lastband.assign(ncomp, -1);
+                rep.assign(ncomp, 0);
+                running.assign(ncomp, 0);
+
+                for (int b = 0; b < nthreads; b++)
+                {
+                    int bbase = bands[b].base, bend = bbase + int(bands[b].parent.size());
+
+                    for (k = bbase; k < bend; k++)
+                    {
+                        c = gfinal[k] - 1;
+
+                        if (lastband[c] != b)
+                        {
+                            lastband[c] = b;
+                            rep[c] = k;
+                            gcursor[k] = running[c];
+                        }
+
+                        grep[k] = rep[c];
+                        running[c] += gcount[k];
+                    }
+                }
+            }
+        }
+        barrier.wait();
+
+        //////////////// Relabel and scatter ////////////////
+        for (r = band.rstart; r < band.rend; r++)
+        {
+            int *lrow = lab.ptr<int>(r);
+            uchar *mrow = (mask != nullptr) ? mask->ptr<uchar>(r) : nullptr;
+
+            for (c = 0; c < ncols; c++)
+            {
+                if (lrow[c] == 0)
+                {
+                    if (mrow != nullptr)
+                        mrow[c] = 0;
+                    continue;
+                }
+
+                k = base + lrow[c] - 1;
+                l = gfinal[k];
+                lrow[c] = l;
+
+                if (mrow != nullptr)
+                    mrow[c] = (outidx[l - 1] >= 0) ? 255 : 0;
+
+                if (alloc && outidx[l - 1] >= 0)
+                    storage[outidx[l - 1]][gcursor[grep[k]]++] = r * ncols + c;
+            }
+        }
+    });
+}
+
+Mat conncomp_helper::areaopen_mt(Mat m, int size, int conn)
+{
+    Mat lab, mask;
+
+    label_mt(m, lab, size, conn, ComponentAllocator(), &mask);
+
+    return mask;
+}
+
+vector<vector<int>> conncomp_helper::label_mt(Mat m, Mat& lab, int size, int conn)
+{
+    vector<vector<int>> result;
+
+    label_mt(m, lab, size, conn, [&](const vector<int>& sizes, vector<int *>& storage)
+    {
+        result.resize(sizes.size());
+        storage.resize(sizes.size());
+
+        for (size_t i = 0; i < sizes.size(); i++)
+        {
+            result[i].resize(sizes[i]);
+            storage[i] = result[i].data();
+        }
+    });
+
+    return result;
+}
+
+void conncomp_helper::label_mt(Mat m, Mat& lab, int size, int conn, cvutil::ComponentList& components, bool stats)
+{
+    components.imsize = m.size();
+    components.bboxes.clear();
+    components.areas.clear();
+
+    // All the retained components share a single index array.
+    label_mt(m, lab, size, conn, [&](const vector<int>& sizes, vector<int *>& storage)
+    {
+        int n = int(sizes.size());
+
+        components.offsets.resize(n + 1);
+        components.offsets[0] = 0;
+
+        for (int i = 0; i < n; i++)
+            components.offsets[i + 1] = components.offsets[i] + sizes[i];
+
+        components.indices.resize(components.offsets[n]);
+        storage.resize(n);
+
+        for (int i = 0; i < n; i++)
+            storage[i] = components.indices.data() + components.offsets[i];
+    });
+
+    if (!stats)
+        return;
+
+    int n = components.size(), ncols = m.cols;
+    components.bboxes.resize(n);
+    components.areas.resize(n);
+
+    threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
+    {
+        int nstart = tid * n / nthreads;
+        int nend = (tid == (nthreads - 1)) ? n : ((tid + 1) * n / nthreads);
+
+        for (int i = nstart; i < nend; i++)
+        {
+            const int *first = components.indices.data() + components.offsets[i];
+            const int *last = components.indices.data() + components.offsets[i + 1];
+
+            // The indices are in raster order, so the first and last
+            // pixels give the top and bottom rows.
+            int top = first[0] / ncols, bottom = last[-1] / ncols;
+            int left = INT_MAX, right = -1;
+
+            for (const int *p = first; p < last; p++)
+            {
+                int c = *p % ncols;
+                left = min(left, c);
+                right = max(right, c);
+            }
+
+            components.areas[i] = int(last - first);
+            components.bboxes[i] = Rect(left, top, right - left + 1, bottom - top + 1);
+        }
+    });
+}
@@ -0,0 +1,67 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_conncomp.h
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef CVUTIL_CONNCOMP_H
+#define CVUTIL_CONNCOMP_H
+
+#include "cvutil.h"
+
+#include <functional>
+
+namespace conncomp_helper
+{
+    // Called once, by a single worker, with the number of pixels of
+    // each retained component. Must set storage[i] to a buffer that
+    // receives the pixel indices of the i-th retained component.
+    typedef std::function<void(const std::vector<int>& sizes, std::vector<int *>& storage)> ComponentAllocator;
+
+    // Labels the non-zero pixels of the continuous CV_8UC1 image m.
+    // lab is set to a CV_32S image with the components numbered 1..n
+    // in the raster order of their first pixel (0 for background).
+    // The linear pixel indices, in raster order, of the components
+    // having more than size pixels (all the components if size <= 0)
+    // are written to the buffers given by alloc. If alloc is empty, the
+    // pixel lists are not collected. If mask is not null, it is set to
+    // a CV_8UC1 image with the retained components set to 255.
+    void label_mt(cv::Mat m, cv::Mat& lab, int size, int conn, const ComponentAllocator& alloc, cv::Mat *mask = nullptr);
+
+    // Returns the mask of the components having more than size pixels,
+    // without collecting the pixel lists.
+    cv::Mat areaopen_mt(cv::Mat m, int size, int conn);
+
+    // Same as above, returning one vector per component.
+    std::vector<std::vector<int>> label_mt(cv::Mat m, cv::Mat& lab, int size, int conn);
+
+    // Same as above, filling a compact component list. The bounding
+    // boxes and areas are computed if stats is true.
+    void label_mt(cv::Mat m, cv::Mat& lab, int size, int conn, cvutil::ComponentList& components, bool stats);
+}
+
+#endif
@@ -28,16 +28,24 @@ along with cvutil; see the file COPYING.  If not, see
 
 #include "cvutil.h"
 
+#include "cvutil_bwdist.h"
 #include "cvutil_bwthin.h"
+#include "cvutil_conncomp.h"
+#include "cvutil_imagewriter.h"
 #include "cvutil_linesim.h"
 #include "cvutil_bwskel.h"
+#include "cvutil_skelgraph.h"
 #include "cvutil_types.h"
 
 #include "MainWindow/MainWindow.h"
 #include "MainWindow/MaterialStyle.h"
 
+#include <atomic>
+#include <memory>
+
 using namespace std;
 using namespace cv;
+using namespace imagewriter_helper;
 
 vector<WinData *> GlobalValues::figures;
 //bool GlobalValues::cswitch = false;
@@ -94,15 +102,21 @@ Mat cvutil::getEdgeDetect(Mat img, int lim)
 
 Mat cvutil::getLargestConnectedComponent(Mat img)
 {
-    Mat out;
-    size_t cc, maxcc = 0;
+    ComponentList components;
+    getConnectedComponents(img, components);
+
+    return getLargestConnectedComponent(components);
+}
+
+Mat cvutil::getLargestConnectedComponent(const ComponentList& components)
+{
+    int cc, maxcc = 0;
     int maxidx = -1;
-    vector<vector<int>> components = getConnectedComponents(img);
-    size_t ncomp = components.size();
+    int ncomp = components.size();
 
     for (int i = 0; i < ncomp; i++)
     {
-        cc = components[i].size();
+        cc = components.count(i);
 
         if (cc > maxcc)
         {
@@ -115,200 +129,53 @@ Mat cvutil::getLargestConnectedComponent(Mat img)
     if (maxidx == -1)
         return Mat::zeros(1, 1, CV_8UC1);
 
-    Mat lab = Mat::zeros(img.size(), CV_8UC1);
+    Mat lab = Mat::zeros(components.imsize, CV_8UC1);
     uchar* data = lab.ptr<uchar>();
     uchar c = static_cast<uchar>(255);
 
-    for (int i = 0; i < components[maxidx].size(); i++)
-        data[components[maxidx][i]] = c;
-
-    out = lab;
+    for (const int *p = components.begin(maxidx); p != components.end(maxidx); p++)
+        data[*p] = c;
 
-    return out;
+    return lab;
 }
 
 vector<vector<int>> cvutil::getConnectedComponents(Mat img, int size, int conn)
+{
+    Mat lab;
+    return getConnectedComponents(img, lab, size, conn);
+}
+
+vector<vector<int>> cvutil::getConnectedComponents(Mat img, Mat& lab, int size, int conn)
 {
     CV_ASSERT2(img.channels() == 1, "img must be a single channel image.");
     CV_ASSERT2(conn == 4 || conn == 8, "connectivity value must be either 4 or 8.");
-    int ncomp, npixels = 0, nrequiredcomp = 0, i;
     Mat m = img.clone();
-    Mat lab(img.size(), CV_32S);
     m.convertTo(m, CV_8UC1);
 
-    ncomp = connectedComponents(m, lab, conn);
-    vector<vector<int>> result;
-    
-    int nelements = img.size().height * img.size().width;
-    int *data = lab.ptr<int>();
-    int *idx;
-    int *rvals;
-    int **vals;
-
-    vector<int> nsizedata(ncomp);
-    int *nsize = nsizedata.data();
-
-    for (i = 0; i < nelements; i++)
-    {
-        if (data[i] != 0)
-            nsize[data[i] - 1]++;
-    }
-    
-    if (size <= 0)
-    {
-        ncomp--;
-        result.resize(ncomp);
-        idx = new int[ncomp]();
-        vals = new int*[ncomp];
-
-        for (i = 0; i < ncomp; i++)
-        {
-            result[i].resize(nsize[i]);
-            vals[i] = result[i].data();
-        }
-        for (i = 0; i < nelements; i++)
-        {
-            if (data[i] != 0)
-            {
-                vals[data[i] - 1][idx[data[i] - 1]] = i;
-                idx[data[i] - 1]++;
-            }
-        }
-    }
-    else
-    {
-        for (i = 0, nrequiredcomp = 0; i < ncomp; i++)
-        {
-            if (nsize[i] > size)
-                nrequiredcomp++;
-        }
-
-        result.resize(nrequiredcomp);
-        idx = new int[nrequiredcomp]();
-        rvals = new int[ncomp]();
-        vals = new int*[nrequiredcomp];
-
-        for (i = 0, nrequiredcomp = 0; i < ncomp; i++)
-        {
-            if (nsize[i] > size)
-            {
-                result[nrequiredcomp].resize(nsize[i]);
-                vals[nrequiredcomp] = result[nrequiredcomp].data();
-                rvals[i] = nrequiredcomp;
-                nrequiredcomp++;
-            }
-            else
-                rvals[i] = -1;
-        }
-
-        for (i = 0; i < nelements; i++)
-        {
-            if (data[i] != 0 && rvals[data[i] - 1] >= 0)
-            {
-                vals[rvals[data[i] - 1]][idx[rvals[data[i] - 1]]] = i;
-                idx[rvals[data[i] - 1]]++;
-            }
-        }
-
-        delete[] rvals;
-    }
-
-    delete[] vals;
-    delete[] idx;
-
-    return result;
+    // Labels the image and collects the pixel lists of the components
+    // in a single parallel pass.
+    return conncomp_helper::label_mt(m, lab, size, conn);
 }
 
-vector<vector<int>> cvutil::getConnectedComponents(Mat img, Mat& lab, int size, int conn)
+void cvutil::getConnectedComponents(Mat img, ComponentList& components, int size, int conn, bool stats)
 {
     CV_ASSERT2(img.channels() == 1, "img must be a single channel image.");
     CV_ASSERT2(conn == 4 || conn == 8, "connectivity value must be either 4 or 8.");
-    int ncomp, npixels = 0, nrequiredcomp = 0, i;
     Mat m = img.clone();
-    lab = Mat(img.size(), CV_32S);
+    Mat lab;
     m.convertTo(m, CV_8UC1);
 
-    ncomp = connectedComponents(m, lab, conn);
-    vector<vector<int>> result;
-
-    int nelements = img.size().height * img.size().width;
-    int *data = lab.ptr<int>();
-    int *idx;
-    int *rvals;
-    int **vals;
-
-    vector<int> nsizedata(ncomp);
-    int *nsize = nsizedata.data();
-
-    for (i = 0; i < nelements; i++)
-    {
-        if (data[i] != 0)
-            nsize[data[i] - 1]++;
-    }
-
-    if (size <= 0)
-    {
-        ncomp--;
-        result.resize(ncomp);
-        idx = new int[ncomp]();
-        vals = new int*[ncomp];
-
-        for (i = 0; i < ncomp; i++)
-        {
-            result[i].resize(nsize[i]);
-            vals[i] = result[i].data();
-        }
-        for (i = 0; i < nelements; i++)
-        {
-            if (data[i] != 0)
-            {
-                vals[data[i] - 1][idx[data[i] - 1]] = i;
-                idx[data[i] - 1]++;
-            }
-        }
-    }
-    else
-    {
-        for (i = 0, nrequiredcomp = 0; i < ncomp; i++)
-        {
-            if (nsize[i] > size)
-                nrequiredcomp++;
-        }
-
-        result.resize(nrequiredcomp);
-        idx = new int[nrequiredcomp]();
-        rvals = new int[ncomp]();
-        vals = new int*[nrequiredcomp];
-
-        for (i = 0, nrequiredcomp = 0; i < ncomp; i++)
-        {
-            if (nsize[i] > size)
-            {
-                result[nrequiredcomp].resize(nsize[i]);
-                vals[nrequiredcomp] = result[nrequiredcomp].data();
-                rvals[i] = nrequiredcomp;
-                nrequiredcomp++;
-            }
-            else
-                rvals[i] = -1;
-        }
-
-        for (i = 0; i < nelements; i++)
-        {
-            if (data[i] != 0 && rvals[data[i] - 1] >= 0)
-            {
-                vals[rvals[data[i] - 1]][idx[rvals[data[i] - 1]]] = i;
-                idx[rvals[data[i] - 1]]++;
-            }
-        }
-
-        delete[] rvals;
-    }
+    conncomp_helper::label_mt(m, lab, size, conn, components, stats);
+}
 
-    delete[] vals;
-    delete[] idx;
+Mat cvutil::bwareaopen(Mat img, int size, int conn)
+{
+    CV_ASSERT2(img.channels() == 1, "img must be a single channel image.");
+    CV_ASSERT2(conn == 4 || conn == 8, "connectivity value must be either 4 or 8.");
+    Mat m = img.clone();
+    m.convertTo(m, CV_8UC1);
 
-    return result;
+    return conncomp_helper::areaopen_mt(m, size, conn);
 }
 
 void onMouse(int event, int _x, int _y, int flags, void *data)
@@ -503,101 +370,161 @@ void cvutil::window(cv::String winname, Mat m)
     waitKey(0);
 }
 
-Mat cvutil::bwthin(Mat input)
+Mat cvutil::bwthin(Mat input, ThinningType type)
 {
     CV_ASSERT2(input.channels() == 1 && input.depth() == 0, "input must be single channel with depth CV_8U containing values 0 and 255 (binary image).");
 
-    Mat inputc = input.clone();
+    Mat inputc;
     
     // Add 1-pixel width of black pixels as boundary to the input image to avoid
-    // boundary errors.
-    hconcat(Mat::zeros(inputc.rows, 1, inputc.type()), inputc, inputc);
-    hconcat(inputc, Mat::zeros(inputc.rows, 1, inputc.type()), inputc);
-
-    vconcat(Mat::zeros(1, inputc.cols, inputc.type()), inputc, inputc);
-    vconcat(inputc, Mat::zeros(1, inputc.cols, inputc.type()), inputc);
-
-    pair<Mat, Mat> psubs = find(inputc == 255, FindType::Subscripts);
-    Mat subs = psubs.first;
-    Mat inds = sub2ind(inputc.size(), subs);
-    hconcat(subs, Mat::ones(subs.rows, 2, subs.type()), subs);
+    // boundary errors. Any nonzero pixel is foreground, and is set to 255
+    // so that all the engines see the same foreground.
+    copyMakeBorder(input != 0, inputc, 1, 1, 1, 1, BORDER_CONSTANT, Scalar(0));
+
+    // cvutil::init() turns the optimizations off with
+    // cv::setUseOptimized(false). In that case, the sparse engine runs
+    // on the calling thread only, as the single-threaded engine did.
+    bool optimized = useOptimized();
+
+    // The dense engine scans 64 pixels for the cost of about one
+    // foreground pixel of the sparse engine, so the sparse engine is
+    // used only when less than 1 in 64 pixels are in the foreground.
+    if (!optimized)
+        type = ThinningType::Sparse;
+    else if (type == ThinningType::Auto)
+        type = (size_t(countNonZero(inputc)) * 64 < inputc.total()) ? ThinningType::Sparse : ThinningType::Frontier;
 
     Mat out;
 
-    if (useOptimized())
-        out = bwthin_helper::bwthin_mt_thread(inputc, subs, inds);
+    if (type == ThinningType::Dense)
+        out = bwthin_helper::bwthin_dense(inputc);
+    else if (type == ThinningType::Frontier)
+        out = bwthin_helper::bwthin_frontier(inputc);
     else
-        out = bwthin_helper::bwthin_st(inputc, subs, inds);
+    {
+        // The row runs take 12 bytes per run instead of the 16 bytes
+        // per pixel of the subscript and index lists.
+        Mat runs = find(inputc, FindType::Runs).first;
+        out = bwthin_helper::bwthin_runs(inputc, runs, !optimized);
+    }
 
     Mat result = out.rowRange(1, inputc.rows - 1).colRange(1, inputc.cols - 1);
     return result.clone();
 }
 
-Mat cvutil::bwskel(Mat input, Mat distance)
+// Sets the border of the given thickness of m to zero.
+static void zeroBorder(Mat& m, int thickness)
 {
-    CV_ASSERT2(input.channels() == 1 && input.depth() == 0, "input must be single channel with depth CV_8U containing values 0 and 255 (binary image).");
-    CV_ASSERT2(distance.empty() || (distance.channels() == 1 && distance.depth() == CV_32F), "distance must be either empty or a single channel CV_32F matrix.");
-    
-    Mat inputc = input.clone();
-    Mat distc;
-    
-    if (distance.empty())
-        distc = bwdist(inputc);
-    else
-        distc = distance;
-    
-    // Round to 3 decimal places.
-    //distc = floor(distc * 1000.0f + 0.5f) / 1000.0f;
-    
-    // Add 2-pixel width of black pixels as boundary to the input image to avoid
-    // boundary errors.
-    hconcat(Mat::zeros(distc.rows, 2, distc.type()), distc, distc);
-    hconcat(distc, Mat::zeros(distc.rows, 2, distc.type()), distc);
+    m.rowRange(0, thickness).setTo(0);
+    m.rowRange(m.rows - thickness, m.rows).setTo(0);
+    m.colRange(0, thickness).setTo(0);
+    m.colRange(m.cols - thickness, m.cols).setTo(0);
+}
+
+// Runs bwskel_helper::bwskel() on the buffers of the workspace, padded
+// by 2 pixels to avoid boundary errors. If distance is empty, the
+// distance map is computed into the workspace. Returns the padded
+// skeleton.
+static Mat bwskel_padded(Mat input, Mat distance, SkeletonWorkspace& ws)
+{
+    Size padded(input.cols + 4, input.rows + 4);
+    Rect roi(2, 2, input.cols, input.rows);
 
-    vconcat(Mat::zeros(2, distc.cols, distc.type()), distc, distc);
-    vconcat(distc, Mat::zeros(2, distc.cols, distc.type()), distc);
+    // create() does not reallocate if the workspace is already of the
+    // required size and type.
+    ws.input.create(padded, CV_8UC1);
+    ws.distance.create(padded, CV_32FC1);
+    zeroBorder(ws.input, 2);
+    zeroBorder(ws.distance, 2);
 
-    hconcat(Mat::zeros(inputc.rows, 2, inputc.type()), inputc, inputc);
-    hconcat(inputc, Mat::zeros(inputc.rows, 2, inputc.type()), inputc);
+    input.copyTo(ws.input(roi));
 
-    vconcat(Mat::zeros(2, inputc.cols, inputc.type()), inputc, inputc);
-    vconcat(inputc, Mat::zeros(2, inputc.cols, inputc.type()), inputc);
+    Mat dist = ws.distance(roi);
 
-    // To make Mats continuous
-    Mat dist = distc.clone();
-    inputc = inputc.clone();
+    if (!distance.empty())
+        distance.copyTo(dist);
+    else if (checkHardwareSupport(CPU_AVX2))
+        bwdist_helper::bwdist_mt(input, dist);
+    else
+        bwdist_helper::bwdist_mt_no_avx(input, dist);
     
-    Mat out = bwskel_helper::bwskel(inputc, dist);
+    Mat out = bwskel_helper::bwskel(ws.input, ws.distance);
     //Mat result = out.rowRange(1, out.rows - 1).colRange(1, out.cols - 1);
     
-    bwskel_helper::rectify_components(out, dist, inputc);
+    bwskel_helper::rectify_components(out, ws.distance, ws.input);
+    
+    return out;
+}
+
+Mat cvutil::bwskel(Mat input, Mat distance)
+{
+    CV_ASSERT2(input.channels() == 1 && input.depth() == 0, "input must be single channel with depth CV_8U containing values 0 and 255 (binary image).");
+    CV_ASSERT2(distance.empty() || (distance.channels() == 1 && distance.depth() == CV_32F), "distance must be either empty or a single channel CV_32F matrix.");
+    CV_ASSERT2(distance.empty() || distance.size() == input.size(), "distance must be of the same size as input.");
+    
+    SkeletonWorkspace ws;
+    Mat out = bwskel_padded(input, distance, ws);
     
     return out.rowRange(2, out.rows - 2).colRange(2, out.cols - 2).clone();
 }
 
+void cvutil::bwskel(Mat input, Mat& skeleton, Mat& distance, SkeletonWorkspace *workspace)
+{
+    CV_ASSERT2(input.channels() == 1 && input.depth() == 0, "input must be single channel with depth CV_8U containing values 0 and 255 (binary image).");
+
+    SkeletonWorkspace local;
+    SkeletonWorkspace& ws = (workspace != nullptr) ? *workspace : local;
+    Mat out = bwskel_padded(input, Mat(), ws);
+
+    skeleton = out.rowRange(2, out.rows - 2).colRange(2, out.cols - 2);
+    distance = ws.distance.rowRange(2, out.rows - 2).colRange(2, out.cols - 2);
+}
+
+void cvutil::getSkeletonGraph(Mat skeleton, SkeletonGraph& graph, Mat distance)
+{
+    CV_ASSERT2(skeleton.channels() == 1, "skeleton must be a single channel image.");
+    CV_ASSERT2(distance.empty() || (distance.channels() == 1 && distance.size() == skeleton.size()), "distance must be a single channel image of the same size as skeleton.");
+
+    // The views returned by bwskel() are not continuous.
+    Mat skel = (skeleton != 0);
+    Mat dist;
+
+    if (!distance.empty())
+    {
+        if (distance.depth() == CV_32F && distance.isContinuous())
+            dist = distance;
+        else
+            distance.convertTo(dist, CV_32F);
+    }
+
+    skelgraph_helper::build_graph(skel, dist, graph);
+}
+
 std::vector<cv::Point> cvutil::doughlas_peucker(const std::vector<cv::Point>& contour, double epsilon, bool isCircular)
 {
     return linesim_helper::doughlas_peucker(contour, epsilon, isCircular);
 }
 
-Mat cvutil::linesim(Mat input, LineSimplificationType type, double epsilon)
+Mat cvutil::linesim(Mat input, LineSimplificationType type, double epsilon, int nthreads)
+{
+    Mat result;
+
+    linesim(input, result, type, epsilon, nthreads);
+    return result;
+}
+
+void cvutil::linesim(Mat input, Mat& output, LineSimplificationType type, double epsilon, int nthreads)
 {
     CV_ASSERT2(input.channels() == 1 && input.depth() == 0, "input must be single channel with depth CV_8U containing values 0 and 255 (binary image).");
-    
-    Mat inputc = input.clone();
 
-    // Add 1-pixel width of black pixels as boundary to the input image to avoid
-    // boundary errors.
-    hconcat(Mat::zeros(input.rows, 1, input.type()), inputc, inputc);
-    hconcat(inputc, Mat::zeros(input.rows, 1, input.type()), inputc);
+    linesim_helper::linesim_mt(input, output, type, epsilon, nthreads);
+}
 
-    vconcat(Mat::zeros(1, inputc.cols, input.type()), inputc, inputc);
-    vconcat(inputc, Mat::zeros(1, inputc.cols, input.type()), inputc);
+void cvutil::linesim(Mat input, vector<vector<Point>>& contours, vector<Vec4i>& hierarchy, LineSimplificationType type, double epsilon, int nthreads)
+{
+    CV_ASSERT2(input.channels() == 1 && input.depth() == 0, "input must be single channel with depth CV_8U containing values 0 and 255 (binary image).");
 
-    Mat out = linesim_helper::linesim_st(inputc, epsilon);
-    
-    Mat result = out.rowRange(1, inputc.rows - 1).colRange(1, inputc.cols - 1);
-    return result;
+    linesim_helper::linesim_contours(input, contours, hierarchy, type, epsilon, nthreads);
 }
 
 Mat cvutil::getMat(InputArray y)
@@ -876,7 +803,7 @@ void cvutil::drawText(Mat &GeomLayer, const string & text, Point org, Scalar col
         putText(GeomLayer, text, org, fontname, fontsize, s, thickness, CV_AA);
 }
 
-Mat cvutil::getImageFromComponents(Size sz, vector<vector<int>> components)
+Mat cvutil::getImageFromComponents(Size sz, const vector<vector<int>>& components)
 {
     Mat result = Mat::zeros(sz, CV_8UC1);
     unsigned char *data = result.ptr<unsigned char>();
@@ -888,6 +815,17 @@ Mat cvutil::getImageFromComponents(Size sz, vector<vector<int>> components)
     return result;
 }
 
+Mat cvutil::getImageFromComponents(const ComponentList& components)
+{
+    Mat result = Mat::zeros(components.imsize, CV_8UC1);
+    unsigned char *data = result.ptr<unsigned char>();
+
+    for (const auto &index : components.indices)
+        data[index] = 255;
+
+    return result;
+}
+
 Ptr<cvutilWindow> cvutil::getImageProcessorWindow(QIcon appico)
 {
     static MainWindow *result = nullptr;
@@ -914,6 +852,49 @@ Mat cvutil::imread(QString& filename, int flags)
     return imdecode(vector<uchar>(arr.begin(), arr.end()), flags);
 }
 
+// Asynchronous writes are enabled per thread, so that only the images
+// written by the thread that enabled them (the batch thread) are queued,
+// while the other callers of imwrite() keep writing synchronously and
+// get the result of the write. The writer runs while any thread has them
+// enabled.
+static thread_local bool asyncwrite = false;
+static mutex asyncmtx;
+static int asyncthreads = 0;
+
+// Failure flag of the images written by the calling thread since its last
+// call to afterImageWrites(). The queued writes of these images share the
+// flag, which is handed over to the job of afterImageWrites().
+static thread_local shared_ptr<atomic<bool>> writefailed;
+
+static shared_ptr<atomic<bool>> writestatus()
+{
+    if (!writefailed)
+        writefailed = make_shared<atomic<bool>>(false);
+
+    return writefailed;
+}
+
+// Encodes the image and writes it to the file.
+static bool imwrite_file(QString filename, QString ext, Mat img, const std::vector<int>& params)
+{
+    std::vector<uchar> buffer;
+    bool result = imencode(ext.toStdString(), img, buffer, params);
+
+    QByteArray arr(reinterpret_cast<const char*>(buffer.data()), static_cast<int>(buffer.size()));
+
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly))
+    {
+        qCritical() << "Cannot write to the file. Image write failure.";
+        return false;
+    }
+    
+    file.write(arr);
+    file.close();
+
+    return result;
+}
+
 bool cvutil::imwrite(QString filename, Mat img, const std::vector<int> & params)
 {
     if (filename.length() == 0)
@@ -944,24 +925,87 @@ bool cvutil::imwrite(QString filename, Mat img, const std::vector<int> & params)
         return false;
     }
 
-    std::vector<uchar> buffer;
-    bool result = imencode(ext.toStdString(), img, buffer, params);
+    // The image is copied, as the caller may reuse its buffer for the
+    // next image before the writer gets to it.
+    ImageWriter& writer = ImageWriter::GetInstance();
 
-    QByteArray arr(reinterpret_cast<const char*>(buffer.data()), static_cast<int>(buffer.size()));
-
-    QFile file(filename);
-    if (!file.open(QFile::WriteOnly))
+    if (asyncwrite && writer.isstarted())
     {
-        qCritical() << "Cannot write to the file. Image write failure.";
-        return false;
+        Mat copy = img.clone();
+
+        // imencode() throws for the images the format cannot encode. On
+        // the writer thread, this is reported as a failed write instead
+        // of terminating the process.
+        shared_ptr<atomic<bool>> status = writestatus();
+
+        auto job = [filename, ext, copy, params, status]()
+        {
+            bool result = false;
+
+            try
+            {
+                result = imwrite_file(filename, ext, copy, params);
+            }
+            catch (const cv::Exception& e)
+            {
+                qCritical() << "Cannot encode the image:" << e.what();
+            }
+            catch (const std::exception& e)
+            {
+                qCritical() << "Cannot encode the image:" << e.what();
+            }
+
+            if (!result)
+            {
+                qCritical() << "Image write failure:" << filename;
+                *status = true;
+            }
+        };
+
+        if (writer.push(job))
+            return true;
     }
-    
-    file.write(arr);
-    file.close();
+
+    bool result = imwrite_file(filename, ext, img, params);
+
+    if (!result)
+        *writestatus() = true;
 
     return result;
 }
 
+void cvutil::setAsyncImageWrite(bool on, int nwriters, int capacity)
+{
+    ImageWriter& writer = ImageWriter::GetInstance();
+
+    if (on == asyncwrite)
+        return;
+
+    asyncwrite = on;
+    lock_guard<mutex> lock(asyncmtx);
+
+    if (on)
+    {
+        if (asyncthreads++ == 0)
+            writer.start(nwriters, capacity);
+    }
+    else if (--asyncthreads == 0)
+        writer.stop();
+    else
+        writer.flush();
+}
+
+void cvutil::afterImageWrites(std::function<void(bool written)> job)
+{
+    shared_ptr<atomic<bool>> status = writestatus();
+    writefailed = nullptr;
+
+    if (asyncwrite)
+        ImageWriter::GetInstance().after([job, status]() { job(!*status); });
+    else
+        job(!*status);
+}
+
 //void cvutil::setSwitch(bool on)
 //{
 //    GlobalValues::cswitch = on;
@@ -39,6 +39,27 @@ namespace cvutil
     CVUTILAPI cv::Mat getSingleChannel(cv::Mat m, int type);
     CVUTILAPI cv::Mat getEdgeDetect(cv::Mat img, int lim);
 
+    // ComponentList
+    // Compact list of connected components. Instead of one vector per
+    // component, the pixel indices of all the components are stored in
+    // a single array. The 1-D pixel indices of the i-th component, in
+    // raster order, are
+    //      indices[offsets[i]], ..., indices[offsets[i + 1] - 1].
+    // The bounding boxes and areas are filled only when requested.
+    struct ComponentList
+    {
+        cv::Size imsize;                // Size of the labeled image
+        std::vector<int> offsets;       // size() + 1 elements
+        std::vector<int> indices;
+        std::vector<cv::Rect> bboxes;   // Optional
+        std::vector<int> areas;         // Optional
+
+        int size() const { return offsets.empty() ? 0 : static_cast<int>(offsets.size()) - 1; }
+        int count(int i) const { return offsets[i + 1] - offsets[i]; }
+        const int *begin(int i) const { return indices.data() + offsets[i]; }
+        const int *end(int i) const { return indices.data() + offsets[i + 1]; }
+    };
+
     // getLargestConnectedComponent()
     // Returns largest connected component from a binary image.
     // 
@@ -49,6 +70,7 @@ namespace cvutil
     //      Mat object of the same size as img containing
     //      binary image of the largest connected component.
     CVUTILAPI cv::Mat getLargestConnectedComponent(cv::Mat img);
+    CVUTILAPI cv::Mat getLargestConnectedComponent(const ComponentList& components);
 
     // getConnectedComponents()
     // Gets connected components from a binary image.
@@ -66,16 +88,142 @@ namespace cvutil
     CVUTILAPI std::vector<std::vector<int>> getConnectedComponents(cv::Mat img, int size = -1, int conn = 8);
     CVUTILAPI std::vector<std::vector<int>> getConnectedComponents(cv::Mat img, cv::Mat& lab, int size = -1, int conn = 8);
 
+    // Same as above, but fills a ComponentList. If stats is true, the
+    // bounding boxes and areas of the components are also computed.
+    CVUTILAPI void getConnectedComponents(cv::Mat img, ComponentList& components, int size = -1, int conn = 8, bool stats = false);
+
+    // bwareaopen()
+    // Removes the small connected components from a binary image.
+    // This gives the same image as getImageFromComponents() applied
+    // on the output of getConnectedComponents(), but the pixel lists
+    // of the components are never built.
+    // 
+    // Input :
+    // img  -  Single channel binary image.
+    // size -  Components with at most size pixels are removed.
+    // conn -  Connectivity, either 4 or 8.
+    // Output :
+    //      CV_8UC1 image of the same size as img with the retained
+    //      components set to 255.
+    CVUTILAPI cv::Mat bwareaopen(cv::Mat img, int size, int conn = 8);
+
     CVUTILAPI void window(cv::String winname, cv::Mat m);
     CVUTILAPI void printheader(cv::Mat m);
 
-    CVUTILAPI cv::Mat bwthin(cv::Mat input);
+    // Thinning engines for bwthin(). Sparse visits the foreground
+    // pixels one at a time, stored as row runs, while Dense evaluates
+    // the thinning tables on 64 bit-packed pixels at a time. Frontier
+    // is the same as Dense, but after the first iteration only revisits
+    // the pixels next to the deleted ones, which is faster for thick
+    // objects. Auto selects the engine based on the fraction of
+    // foreground pixels in the image. Any nonzero pixel of the input is
+    // foreground, and all the engines give the same result. If
+    // cv::useOptimized() is false, the sparse engine is run on a single
+    // thread whatever the type.
+    enum class ThinningType { Auto, Sparse, Dense, Frontier };
+
+    CVUTILAPI cv::Mat bwthin(cv::Mat input, ThinningType type = ThinningType::Auto);
     CVUTILAPI cv::Mat bwskel(cv::Mat input, cv::Mat distance = cv::Mat());
 
-    enum class LineSimplificationType { DouglasPeucker, NPoint };
+    // SkeletonWorkspace
+    // Padded working buffers of bwskel(). Passing the same workspace to
+    // consecutive calls reuses the buffers as long as the image size
+    // does not change.
+    struct SkeletonWorkspace
+    {
+        cv::Mat input;      // CV_8UC1, padded by 2 pixels on each side
+        cv::Mat distance;   // CV_32FC1, padded by 2 pixels on each side
+    };
+
+    // Same as bwskel(input), but also returns the distance map of input
+    // (as given by bwdist()). The distance map is computed directly into
+    // the padded buffer of the workspace, and the skeleton and distance
+    // outputs are views of the padded buffers, so that no copies of the
+    // image are made. If a workspace is given, the distance output is
+    // only valid until the workspace is used again.
+    CVUTILAPI void bwskel(cv::Mat input, cv::Mat& skeleton, cv::Mat& distance, SkeletonWorkspace *workspace = nullptr);
+
+    // SkeletonGraph
+    // Graph of an 8-connected skeleton. The nodes are the skeleton
+    // pixels that do not have exactly two neighbors (end points, branch
+    // points and isolated pixels), and the edges are the chains of
+    // pixels between them. Adjacent nodes are joined by an edge without
+    // interior pixels, and a closed curve without any node gets a node
+    // at its first pixel with a loop edge. The i-th edge joins the nodes
+    //      edges[2 * i] and edges[2 * i + 1],
+    // and its 1-D pixel indices, from the first node to the second and
+    // including both, are
+    //      edgepixels[edgeoffsets[i]], ..., edgepixels[edgeoffsets[i + 1] - 1].
+    // The edges incident to the i-th node are
+    //      adjedges[adjoffsets[i]], ..., adjedges[adjoffsets[i + 1] - 1].
+    struct SkeletonGraph
+    {
+        cv::Size imsize;                // Size of the skeleton image
+        std::vector<int> nodes;         // 1-D pixel index of each node
+        std::vector<int> nodecomps;     // Skeleton component of each node
+        std::vector<int> edges;         // 2 * edgecount() elements
+        std::vector<int> edgeoffsets;   // edgecount() + 1 elements
+        std::vector<int> edgepixels;
+        std::vector<double> lengths;    // Length of each edge in pixels
+        std::vector<double> radii;      // Mean distance map value of each edge
+        std::vector<int> adjoffsets;    // nodecount() + 1 elements
+        std::vector<int> adjedges;
+
+        int nodecount() const { return static_cast<int>(nodes.size()); }
+        int edgecount() const { return static_cast<int>(lengths.size()); }
+        int degree(int i) const { return adjoffsets[i + 1] - adjoffsets[i]; }
+    };
+
+    // getSkeletonGraph()
+    // Builds the graph of a skeleton, such as the output of bwskel().
+    //
+    // Input :
+    // skeleton -  Single channel binary skeleton image.
+    // distance -  Optional CV_32FC1 distance map of the same size as
+    //             skeleton (such as the one returned by bwskel()),
+    //             used for the radii of the edges. If empty, the radii
+    //             are set to 0.
+    // Output :
+    // graph    -  Graph of the skeleton. The nodes and edges are
+    //             ordered by skeleton component, in the raster order of
+    //             the first pixel of the components.
+    CVUTILAPI void getSkeletonGraph(cv::Mat skeleton, SkeletonGraph& graph, cv::Mat distance = cv::Mat());
+
+    // Line simplifiers used by linesim(). The meaning of epsilon
+    // depends on the simplifier:
+    // DouglasPeucker    -  Largest distance (in pixels) of the removed
+    //                      points from the simplified line. The run
+    //                      time is O(n log n) on average and O(n^2) in
+    //                      the worst case.
+    // NPoint            -  Every n-th point is kept, where n is epsilon
+    //                      rounded to the nearest integer. The run time
+    //                      is O(n).
+    // VisvalingamWhyatt -  The points forming a triangle of area at most
+    //                      epsilon * epsilon (in pixels squared) with
+    //                      their neighbors are removed, smallest first.
+    //                      The run time is O(n log n).
+    enum class LineSimplificationType { DouglasPeucker, NPoint, VisvalingamWhyatt };
 
     CVUTILAPI std::vector<cv::Point> doughlas_peucker(const std::vector<cv::Point>& contour, double epsilon, bool isCircular);
-    CVUTILAPI cv::Mat linesim(cv::Mat input, LineSimplificationType type = LineSimplificationType::DouglasPeucker, double epsilon = 1.0);
+
+    // linesim()
+    // Simplifies the contours of the components of a binary image and
+    // returns the image of the filled simplified contours. The contours
+    // are simplified in parallel on at most nthreads workers of the
+    // pool (all of them if nthreads <= 0).
+    CVUTILAPI cv::Mat linesim(cv::Mat input, LineSimplificationType type = LineSimplificationType::DouglasPeucker, double epsilon = 1.0, int nthreads = 0);
+
+    // Same as above, but draws into output, which is only reallocated
+    // if it is not a CV_8UC1 image of the same size as input. Reusing
+    // the same output across calls avoids allocating an image per call.
+    CVUTILAPI void linesim(cv::Mat input, cv::Mat& output, LineSimplificationType type = LineSimplificationType::DouglasPeucker, double epsilon = 1.0, int nthreads = 0);
+
+    // Same as above, but returns the simplified contours instead of
+    // drawing them. The contours and hierarchy are in the format of
+    // cv::findContours() with RETR_TREE, and the contours removed by
+    // the simplification are not listed.
+    CVUTILAPI void linesim(cv::Mat input, std::vector<std::vector<cv::Point>>& contours, std::vector<cv::Vec4i>& hierarchy,
+        LineSimplificationType type = LineSimplificationType::DouglasPeucker, double epsilon = 1.0, int nthreads = 0);
 
     // The following function differs from InputArray::getMat() 
     // in that it converts the vectors into column matrices and vector of
@@ -91,15 +239,43 @@ namespace cvutil
     CVUTILAPI void ForEachFileInPath(std::string path, void(*func)(std::string filename));
 
     CVUTILAPI void init(int &argc, char *argv[], bool useOpt = true, bool useGUI = true);
-    
+
+    // Sets the number of workers (including the calling thread) used by
+    // the multithreaded kernels. If nthreads <= 0, the number of logical
+    // CPUs is used. If pinned is true, each worker is bound to one of
+    // the CPUs the process is allowed to run on. The pool can also be
+    // sized using the CVUTIL_NUM_THREADS and CVUTIL_PIN_THREADS
+    // environment variables. The workers are not pinned by default.
+    CVUTILAPI void setNumWorkers(int nthreads, bool pinned = false);
+    CVUTILAPI int getNumWorkers();
+
     CVUTILAPI void drawText(cv::Mat &GeomLayer, const std::string & text, cv::Point org, cv::Scalar color, int rightmargin, int thickness);
 
-    CVUTILAPI cv::Mat getImageFromComponents(cv::Size sz, std::vector<std::vector<int>> components);
+    CVUTILAPI cv::Mat getImageFromComponents(cv::Size sz, const std::vector<std::vector<int>>& components);
+    CVUTILAPI cv::Mat getImageFromComponents(const ComponentList& components);
 
     // Similar to OpenCV's imread, but supports UTF-8 characters in file path.
     CVUTILAPI cv::Mat imread(QString& filename, int flags = cv::IMREAD_COLOR);
 
     CVUTILAPI bool imwrite(QString filename, cv::Mat img, const std::vector< int > &  	params = std::vector< int >());
+
+    // Asynchronous image writing for batch processing, enabled for the
+    // calling thread only. While it is on, imwrite() called from this
+    // thread queues a copy of the image for nwriters background threads
+    // and returns true, and the failures to write are logged. The other
+    // threads keep writing synchronously. At most capacity images are
+    // queued. Turning it off waits until all the queued images are
+    // written. nwriters and capacity are used by the first thread that
+    // turns it on.
+    CVUTILAPI void setAsyncImageWrite(bool on, int nwriters = 1, int capacity = 8);
+
+    // Runs job once the images passed to imwrite() so far are written,
+    // without waiting for them. job is given true if all the images the
+    // calling thread passed to imwrite() since its previous call to
+    // afterImageWrites() were written, and false if any of them failed.
+    // If asynchronous image writing is off for the calling thread, job
+    // runs before the function returns.
+    CVUTILAPI void afterImageWrites(std::function<void(bool written)> job);
     //CVUTILAPI void setSwitch(bool on);
 }
 
@@ -0,0 +1,173 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_imagewriter.cpp
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#include "cvutil_imagewriter.h"
+
+using namespace std;
+using namespace imagewriter_helper;
+
+ImageWriter& ImageWriter::GetInstance()
+{
+    static ImageWriter writer;
+    return writer;
+}
+
+ImageWriter::~ImageWriter()
+{
+    stop();
+}
+
+void ImageWriter::start(int nwriters, int _capacity)
+{
+    stop();
+
+    lock_guard<mutex> lock(mtx);
+    stopping = false;
+    capacity = size_t(max(1, _capacity));
+
+    for (int i = 0; i < max(1, nwriters); i++)
+        writers.emplace_back(&ImageWriter::work, this);
+}
+
+void ImageWriter::stop()
+{
+    vector<thread> threads;
+
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+        threads.swap(writers);
+    }
+
+    cond.notify_all();
+
+    // The writers leave only after the queue is empty.
+    for (auto& t : threads)
+        t.join();
+}
+
+bool ImageWriter::isstarted()
+{
+    lock_guard<mutex> lock(mtx);
+    return !writers.empty() && !stopping;
+}
+
+bool ImageWriter::push(function<void()> job)
+{
+    unique_lock<mutex> lock(mtx);
+
+    cond.wait(lock, [&] { return writers.empty() || stopping || jobs.size() < capacity; });
+
+    if (writers.empty() || stopping)
+        return false;
+
+    uint64_t seq = nextseq++;
+
+    incomplete.insert(seq);
+    jobs.emplace_back(seq, std::move(job));
+    lock.unlock();
+    cond.notify_all();
+
+    return true;
+}
+
+void ImageWriter::after(function<void()> job)
+{
+    unique_lock<mutex> lock(mtx);
+
+    if (writers.empty())
+    {
+        lock.unlock();
+        job();
+        return;
+    }
+
+    fences.emplace_back(nextseq, std::move(job));
+    runfences(lock);
+}
+
+// Runs the fences whose previous jobs are complete. Only one thread runs
+// the fences at a time, so that they run in order. The other threads
+// leave them to it, and it checks for the fences they made ready before
+// it returns.
+void ImageWriter::runfences(unique_lock<mutex>& lock)
+{
+    if (fencing)
+        return;
+
+    fencing = true;
+
+    while (!fences.empty() && (incomplete.empty() || *incomplete.begin() >= fences.front().first))
+    {
+        function<void()> job = std::move(fences.front().second);
+        fences.pop_front();
+        lock.unlock();
+        job();
+        lock.lock();
+    }
+
+    fencing = false;
+    cond.notify_all();
+}
+
+void ImageWriter::flush()
+{
+    unique_lock<mutex> lock(mtx);
+    cond.wait(lock, [&] { return jobs.empty() && running == 0 && fences.empty() && !fencing; });
+}
+
+void ImageWriter::work()
+{
+    unique_lock<mutex> lock(mtx);
+
+    while (1)
+    {
+        cond.wait(lock, [&] { return stopping || !jobs.empty(); });
+
+        if (jobs.empty())
+            break;
+
+        uint64_t seq = jobs.front().first;
+        function<void()> job = std::move(jobs.front().second);
+        jobs.pop_front();
+        running++;
+        lock.unlock();
+
+        // A slot is free in the queue.
+        cond.notify_all();
+        job();
+
+        lock.lock();
+        running--;
+        incomplete.erase(seq);
+        runfences(lock);
+
+        if (jobs.empty() && running == 0)
+            cond.notify_all();
+    }
+}
@@ -0,0 +1,108 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_imagewriter.h
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef CVUTIL_IMAGEWRITER_H
+#define CVUTIL_IMAGEWRITER_H
+
+#include "stdproto.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace imagewriter_helper
+{
+    // Background writers for cvutil::imwrite(). While the writer is
+    // started, imwrite() hands the encoding and the file write of an
+    // image to one of the writer threads and returns, so the caller can
+    // proceed with the next image while the previous outputs are being
+    // saved. At most capacity jobs are queued, after which push()
+    // blocks until a writer takes one, which bounds the memory held by
+    // the queued images.
+    class ImageWriter
+    {
+        std::mutex mtx;
+        std::condition_variable cond;
+        std::deque<std::pair<uint64_t, std::function<void()>>> jobs;
+        std::vector<std::thread> writers;
+        size_t capacity = 0;
+        int running = 0;    // Jobs being executed by the writers
+        bool stopping = false;
+
+        // Jobs are numbered in the order they are pushed. A job given to
+        // after() waits for the jobs numbered below its own number.
+        uint64_t nextseq = 0;
+        std::set<uint64_t> incomplete;
+        std::deque<std::pair<uint64_t, std::function<void()>>> fences;
+        bool fencing = false;
+
+        ImageWriter() {}
+        ~ImageWriter();
+
+        void work();
+        void runfences(std::unique_lock<std::mutex>& lock);
+
+    public:
+        ImageWriter(const ImageWriter&) = delete;
+        ImageWriter& operator=(const ImageWriter&) = delete;
+
+        static ImageWriter& GetInstance();
+
+        // Starts nwriters threads. If the writer is already started,
+        // the queued jobs are completed before it is restarted.
+        void start(int nwriters, int capacity);
+
+        // Completes the queued jobs and stops the writer threads.
+        void stop();
+
+        bool isstarted();
+
+        // Returns false if the writer is not started, in which case the
+        // caller should run the job itself.
+        bool push(std::function<void()> job);
+
+        // Runs job once all the jobs pushed before it are complete,
+        // without waiting for them. The jobs given to after() run in
+        // the order they are given. If the writer is not started, or
+        // the previous jobs are complete, job runs before after()
+        // returns.
+        void after(std::function<void()> job);
+
+        // Blocks until all the queued jobs, including the ones given to
+        // after(), are complete.
+        void flush();
+    };
+}
+
+#endif
@@ -36,18 +36,139 @@ along with cvutil; see the file COPYING.  If not, see
 // required to represent a digitized line or its caricature. Cartographica: The 
 // International Journal for Geographic Information and Geovisualization 10 (2):112-122
 //
+// Visvalingam-Whyatt Line Simplifier
+//
+// Source:
+// Visvalingam M, Whyatt JD (1993) Line generalisation by repeated elimination of points. 
+// The Cartographic Journal 30 (1):46-51
+//
 
 #include "cvutil_linesim.h"
+#include "cvutil_threadpool.h"
 
 #include "profiler.h"
 
+#include <queue>
+
 using namespace std;
 using namespace cv;
 
+// The distances of the contour points are computed with exact integer
+// arithmetic, so that the AVX2 and the scalar searches always select
+// the same point. cv::Point is a pair of ints, so each 64-bit lane of a
+// vector holds the x (low half) and y (high half) of one point.
+namespace
+{
+    // |a * x - b * y + c|, the distance of the point from the line
+    // through two points, scaled by the length of the segment.
+    struct line_metric
+    {
+        int64_t a, b, c;
+
+        int64_t operator()(const Point& p) const
+        {
+            int64_t v = a * p.x - b * p.y + c;
+            return (v < 0) ? -v : v;
+        }
+
+        // a and b fit in 32 bits, so _mm256_mul_epi32 gives the exact
+        // 64-bit products.
+        __m256i operator()(const Point *p) const
+        {
+            __m256i xy = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            __m256i ax = _mm256_mul_epi32(xy, _mm256_set1_epi64x(a));
+            __m256i by = _mm256_mul_epi32(_mm256_srli_epi64(xy, 32), _mm256_set1_epi64x(b));
+            __m256i v = _mm256_add_epi64(_mm256_sub_epi64(ax, by), _mm256_set1_epi64x(c));
+            __m256i neg = _mm256_sub_epi64(_mm256_setzero_si256(), v);
+
+            return _mm256_blendv_epi8(v, neg, _mm256_cmpgt_epi64(_mm256_setzero_si256(), v));
+        }
+    };
+
+    // Squared distance of the point from the point (x0, y0).
+    struct point_metric
+    {
+        int x0, y0;
+
+        int64_t operator()(const Point& p) const
+        {
+            int64_t dx = p.x - x0, dy = p.y - y0;
+            return dx * dx + dy * dy;
+        }
+
+        __m256i operator()(const Point *p) const
+        {
+            __m256i xy = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            __m256i d = _mm256_sub_epi32(xy, _mm256_set1_epi64x((int64_t(uint32_t(y0)) << 32) | uint32_t(x0)));
+            __m256i dy = _mm256_srli_epi64(d, 32);
+
+            return _mm256_add_epi64(_mm256_mul_epi32(d, d), _mm256_mul_epi32(dy, dy));
+        }
+    };
+
+    // Returns the index in [first, last) of the point with the largest
+    // metric, the first one on ties, or -1 if the metric is 0 for all
+    // the points. The largest metric is returned in maxval.
+    template <typename Metric>
+    int farthest(const Point *pts, int first, int last, const Metric& metric, bool useavx, int64_t& maxval)
+    {
+        int j = first, maxidx = -1;
+
+        maxval = 0;
+
+        if (useavx && last - first >= 8)
+        {
+            __m256i best = _mm256_setzero_si256();
+            __m256i bestidx = _mm256_set1_epi64x(-1);
+            __m256i idx = _mm256_setr_epi64x(first, first + 1, first + 2, first + 3);
+            __m256i four = _mm256_set1_epi64x(4);
+
+            for (; j + 4 <= last; j += 4)
+            {
+                __m256i v = metric(pts + j);
+                __m256i gt = _mm256_cmpgt_epi64(v, best);
+
+                best = _mm256_blendv_epi8(best, v, gt);
+                bestidx = _mm256_blendv_epi8(bestidx, idx, gt);
+                idx = _mm256_add_epi64(idx, four);
+            }
+
+            alignas(32) int64_t lanebest[4], laneidx[4];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanebest), best);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(laneidx), bestidx);
+
+            // Each lane holds the first index of its largest value.
+            for (int k = 0; k < 4; k++)
+            {
+                if (lanebest[k] > maxval || (lanebest[k] == maxval && maxval > 0 && laneidx[k] < maxidx))
+                {
+                    maxval = lanebest[k];
+                    maxidx = int(laneidx[k]);
+                }
+            }
+        }
+
+        for (; j < last; j++)
+        {
+            int64_t v = metric(pts[j]);
+
+            if (v > maxval)
+            {
+                maxval = v;
+                maxidx = j;
+            }
+        }
+
+        return maxidx;
+    }
+}
+
 vector<Point> linesim_helper::doughlas_peucker(const vector<Point>& contour, double epsilon, bool isCircular)
 {
-    double acoef, bcoef, ccoef, invdist, maxdist, maxadist = 0, adist, dist, distlongest = -1;
-    int startidx = -1, stopidx = -1, maxidx = -1, updatept = 0, j;
+    double maxadist = 0, distlongest = -1;
+    int64_t maxval;
+    int startidx = -1, stopidx = -1, maxidx = -1, updatept = 0;
+    bool useavx = checkHardwareSupport(CPU_AVX2);
     vector<int> stopstack;
     vector<Point> pixelstosave;
     vector<Point> localContour;  // Local copy for modification
@@ -107,52 +228,26 @@ vector<Point> linesim_helper::doughlas_peucker(const vector<Point>& contour, dou
 
         if (startidx == 0 && stopidx == localContour.size() - 1)
         {
-            for (j = (startidx + 1), maxadist = 0, maxidx = -1; j < stopidx; j++)
-            {
-                dist = ((localContour[startidx].x - localContour[j].x) * (localContour[startidx].x - localContour[j].x)) +
-                    ((localContour[startidx].y - localContour[j].y) * (localContour[startidx].y - localContour[j].y));
-                adist = fabs(dist);
-
-                if (adist > maxadist)
-                {
-                    maxadist = adist;
-                    maxdist = dist;
-                    maxidx = j;
-                }
-            }
-
-            //distlongest = (acoef * localContour[maxidx].x - bcoef * localContour[maxidx].y + ccoef) * invdist;
-            //maxadist = fabs(dist);
-            //distlongest *= -1;
-            /*maxadist = mloc.first;
-            maxidx = mloc.second;*/
+            maxidx = farthest(localContour.data(), startidx + 1, stopidx,
+                point_metric{ start.x, start.y }, useavx, maxval);
+            maxadist = double(maxval);
         }
         else
         {
-            acoef = localContour[stopidx].y - start.y;
-            bcoef = localContour[stopidx].x - start.x;
-            // We do not need ccoef as we are merely comparing the distances. 
-            ccoef = localContour[stopidx].x * start.y - localContour[stopidx].y * start.x;
-
-            // We probably do not need to use invdist to compute the exact distance
-            // because we just want to know the index of the point with maximum distance.
-            // Hence, we can just make comparisons without calculating invdist. Thus,
-            // the following line is commented.
-            invdist = 1.0 / sqrt(acoef * acoef + bcoef * bcoef);
-            acoef *= invdist;
-            bcoef *= invdist;
-            ccoef *= invdist;
-            
-            for (j = (startidx + 1), maxadist = 0, maxidx = -1; j < stopidx; j++)
+            line_metric metric;
+            metric.a = localContour[stopidx].y - start.y;
+            metric.b = localContour[stopidx].x - start.x;
+            metric.c = int64_t(localContour[stopidx].x) * start.y - int64_t(localContour[stopidx].y) * start.x;
+
+            // The distances are only compared with each other, so the
+            // search is done on the scaled distances and only the
+            // largest one is divided by the length of the segment.
+            if (metric.a == 0 && metric.b == 0)
+                maxidx = -1;
+            else
             {
-                dist = (acoef * double(localContour[j].x) - bcoef * double(localContour[j].y) + ccoef);
-                adist = fabs(dist);
-                
-                if (adist > maxadist)
-                {
-                    maxadist = adist;
-                    maxidx = j;
-                }
+                maxidx = farthest(localContour.data(), startidx + 1, stopidx, metric, useavx, maxval);
+                maxadist = double(maxval) / sqrt(double(metric.a * metric.a + metric.b * metric.b));
             }
         }
 
@@ -189,17 +284,176 @@ vector<Point> linesim_helper::doughlas_peucker(const vector<Point>& contour, dou
     return pixelstosave;
 }
 
-Mat linesim_helper::linesim_st(Mat inputc, double epsilon)
+vector<Point> linesim_helper::npoint(const vector<Point>& contour, int n, bool isCircular)
+{
+    int npts = static_cast<int>(contour.size());
+
+    if (npts <= 2 || n <= 1)
+        return contour;
+
+    vector<Point> pixelstosave;
+    pixelstosave.reserve(npts / n + 2);
+
+    for (int i = 0; i < npts; i += n)
+        pixelstosave.push_back(contour[i]);
+
+    // The last point of an open line is always kept.
+    if (!isCircular && (npts - 1) % n != 0)
+        pixelstosave.push_back(contour[npts - 1]);
+
+    return pixelstosave;
+}
+
+// Twice the area of the triangle formed by the points a, b and c.
+static inline int64_t triangle_area2(const Point& a, const Point& b, const Point& c)
+{
+    int64_t v = int64_t(b.x - a.x) * (c.y - a.y) - int64_t(c.x - a.x) * (b.y - a.y);
+    return (v < 0) ? -v : v;
+}
+
+vector<Point> linesim_helper::visvalingam_whyatt(const vector<Point>& contour, double epsilon, bool isCircular)
+{
+    int npts = static_cast<int>(contour.size());
+    int minpts = isCircular ? 3 : 2;
+
+    if (npts <= minpts)
+        return contour;
+
+    // The points are kept in a doubly linked list, and the removable
+    // points in a heap ordered by area (then by index, so that the
+    // result does not depend on the heap implementation). The entries
+    // of the points whose area changed are left in the heap and are
+    // skipped using the current area.
+    typedef pair<int64_t, int> entry;
+
+    vector<int> prev(npts), next(npts);
+    vector<int64_t> area(npts, -1);
+    vector<uchar> removed(npts, 0);
+    priority_queue<entry, vector<entry>, greater<entry>> heap;
+    int64_t maxarea = static_cast<int64_t>(2.0 * epsilon * epsilon);
+    int remaining = npts;
+
+    for (int i = 0; i < npts; i++)
+    {
+        prev[i] = (i > 0) ? i - 1 : (isCircular ? npts - 1 : -1);
+        next[i] = (i < npts - 1) ? i + 1 : (isCircular ? 0 : -1);
+    }
+
+    auto update = [&](int i)
+    {
+        if (prev[i] == -1 || next[i] == -1)
+            return;
+
+        area[i] = triangle_area2(contour[prev[i]], contour[i], contour[next[i]]);
+        heap.push(entry(area[i], i));
+    };
+
+    for (int i = 0; i < npts; i++)
+        update(i);
+
+    while (!heap.empty() && remaining > minpts)
+    {
+        entry top = heap.top();
+        heap.pop();
+
+        int i = top.second;
+
+        if (top.first != area[i])
+            continue;
+
+        if (top.first > maxarea)
+            break;
+
+        // Remove the point and update the areas of its neighbors.
+        area[i] = -1;
+        removed[i] = 1;
+        next[prev[i]] = next[i];
+        prev[next[i]] = prev[i];
+        remaining--;
+
+        update(prev[i]);
+        update(next[i]);
+    }
+
+    vector<Point> pixelstosave;
+    pixelstosave.reserve(remaining);
+
+    for (int i = 0; i < npts; i++)
+        if (!removed[i])
+            pixelstosave.push_back(contour[i]);
+
+    return pixelstosave;
+}
+
+vector<Point> linesim_helper::simplify(const vector<Point>& contour, cvutil::LineSimplificationType type, double epsilon, bool isCircular)
+{
+    switch (type)
+    {
+    case cvutil::LineSimplificationType::NPoint:
+        return npoint(contour, max(1, cvRound(epsilon)), isCircular);
+    case cvutil::LineSimplificationType::VisvalingamWhyatt:
+        return visvalingam_whyatt(contour, epsilon, isCircular);
+    default:
+        return doughlas_peucker(contour, epsilon, isCircular);
+    }
+}
+
+// Simplifies the contours with more than 2 points, split between at
+// most nthreads workers in ranges of about the same number of points.
+// The contours that simplify to nothing are left as they are and are
+// flagged in isempty.
+static void simplify_contours(vector<vector<Point>>& contours, vector<uchar>& isempty,
+    cvutil::LineSimplificationType type, double epsilon, int nthreads)
+{
+    int ncontours = int(contours.size());
+    vector<long long> offsets(ncontours + 1, 0);
+
+    for (int i = 0; i < ncontours; i++)
+        offsets[i + 1] = offsets[i] + static_cast<long long>(contours[i].size());
+
+    isempty.assign(ncontours, 0);
+
+    threadpool_helper::parallel_run([&](int tid, int poolthreads, threadpool_helper::Barrier& barrier)
+    {
+        int nworkers = (nthreads > 0) ? min(nthreads, poolthreads) : poolthreads;
+
+        if (tid >= nworkers)
+            return;
+
+        auto first_contour = [&](int t) -> int
+        {
+            if (t == nworkers)
+                return ncontours;
+
+            long long p = t * offsets[ncontours] / nworkers;
+            return int(lower_bound(offsets.begin(), offsets.begin() + ncontours, p) - offsets.begin());
+        };
+
+        int cend = first_contour(tid + 1);
+
+        for (int i = first_contour(tid); i < cend; i++)
+        {
+            if (contours[i].size() <= 2)
+                continue;
+
+            vector<Point> updatedcontour = linesim_helper::simplify(contours[i], type, epsilon, true);
+
+            if (updatedcontour.empty())
+                isempty[i] = 1;
+            else
+                contours[i] = move(updatedcontour);
+        }
+    });
+}
+
+void linesim_helper::linesim_contours(Mat input, vector<vector<Point>>& contours, vector<Vec4i>& hierarchy,
+    cvutil::LineSimplificationType type, double epsilon, int nthreads)
 {
     // We now find an 8-connected edge of all the components of the binary image.
-    int ncontoursused = 0, hierarchy_level = 0, max_hierarchy_levels, isparent, nedge = 0, i, j;
-    unsigned char *data = inputc.ptr<unsigned char>();
-    vector<int> stopstack;
+    int hierarchy_level = 0, max_hierarchy_levels, isparent, i, j;
     vector<bool> parentdeleted, hierarchydelete;
-    Point start;
-    vector<Point> updatedcontour;
-    vector<vector<Point>> contours;
-    vector<Vec4i> hierarchy, newhierarchy;
+    vector<uchar> isempty;
+    vector<Vec4i> newhierarchy;
 
     // The border points are 4-connected because we used
     // 8-connectivity to identify the edge pixels (duality!).
@@ -220,8 +474,17 @@ Mat linesim_helper::linesim_st(Mat inputc, double epsilon)
     // the list of edges for each component (first index),
     // then by the edge index (in case the component has 
     // holes).
+    //
+    // findContours() pads its own copy of the image, so neither a copy
+    // nor a padded image is needed here.
     //tic();
-    findContours(inputc.clone(), contours, hierarchy, RETR_TREE, CHAIN_APPROX_SIMPLE);
+    findContours(input, contours, hierarchy, RETR_TREE, CHAIN_APPROX_SIMPLE);
+
+    // The contours are simplified independently of each other, so
+    // this is done for all of them in parallel before walking the
+    // hierarchy. The contours of the deleted parents are simplified
+    // too, but they are never drawn.
+    simplify_contours(contours, isempty, type, epsilon, nthreads);
     
     // To find number of hierarchy_levels.
     for (i = 0, max_hierarchy_levels = 0; i < contours.size(); i++)
@@ -288,14 +551,9 @@ Mat linesim_helper::linesim_st(Mat inputc, double epsilon)
             }
             else if (contours[i].size() > 2)
             {
-                updatedcontour = doughlas_peucker(contours[i], epsilon, true);
-                
-                if (!updatedcontour.empty())
-                    contours[i] = updatedcontour;
-                
                 // If the cuttrnt contour is empty, we need to delete it.
                 // So first we mark it for deletion.
-                parentdeleted[hierarchy_level] = updatedcontour.empty();
+                parentdeleted[hierarchy_level] = isempty[i] != 0;
                 hierarchydelete[i] = parentdeleted[hierarchy_level];
 
                 // Then we update the adjacent contours in the same hierarchy
@@ -362,14 +620,44 @@ Mat linesim_helper::linesim_st(Mat inputc, double epsilon)
         }
     }
     
-    // To draw the contours to result image after line simplification.
-    Mat result = Mat::zeros(inputc.size(), CV_8UC1);;
-    drawContours(result, contours, -1, Scalar(255), FILLED, 8, newhierarchy);
-    
-    contours.clear();
-    hierarchy.clear();
-    newhierarchy.clear();
-    stopstack.clear();
+    // Remove the deleted contours, and renumber the hierarchy of the
+    // remaining ones.
+    int ncontours = static_cast<int>(contours.size()), nkept = 0;
+    vector<int> newidx(ncontours, -1);
+
+    for (i = 0; i < ncontours; i++)
+        if (!hierarchydelete[i])
+            newidx[i] = nkept++;
+
+    auto remap = [&](int k) { return (k == -1) ? -1 : newidx[k]; };
 
-    return result;
+    for (i = 0; i < ncontours; i++)
+    {
+        if (hierarchydelete[i])
+            continue;
+
+        int k = newidx[i];
+
+        if (k != i)
+            contours[k] = move(contours[i]);
+
+        hierarchy[k] = Vec4i(remap(newhierarchy[i][0]), remap(newhierarchy[i][1]),
+            remap(newhierarchy[i][2]), remap(newhierarchy[i][3]));
+    }
+
+    contours.resize(nkept);
+    hierarchy.resize(nkept);
+}
+
+void linesim_helper::linesim_mt(Mat input, Mat& result, cvutil::LineSimplificationType type, double epsilon, int nthreads)
+{
+    vector<vector<Point>> contours;
+    vector<Vec4i> hierarchy;
+
+    linesim_contours(input, contours, hierarchy, type, epsilon, nthreads);
+
+    // To draw the contours to result image after line simplification.
+    result.create(input.size(), CV_8UC1);
+    result.setTo(Scalar(0));
+    drawContours(result, contours, -1, Scalar(255), FILLED, 8, hierarchy);
 }
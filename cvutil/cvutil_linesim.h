@@ -31,13 +31,33 @@ along with cvutil; see the file COPYING.  If not, see
 #ifndef CVUTIL_LINESIM_H
 #define CVUTIL_LINESIM_H
 
-#include "stdproto.h"
+#include "cvutil.h"
 
 namespace linesim_helper
 {
     std::vector<cv::Point> doughlas_peucker(const std::vector<cv::Point>& contour, double epsilon, bool isCircular);
 
-    cv::Mat linesim_st(cv::Mat inputc, double epsilon);
+    // Keeps the first point and every n-th point after it (and the
+    // last point of an open line).
+    std::vector<cv::Point> npoint(const std::vector<cv::Point>& contour, int n, bool isCircular);
+
+    // Repeatedly removes the point forming the smallest triangle with
+    // its two neighbors, as long as the area of the triangle is at most
+    // epsilon * epsilon.
+    std::vector<cv::Point> visvalingam_whyatt(const std::vector<cv::Point>& contour, double epsilon, bool isCircular);
+
+    // Simplifies the contour with the given simplifier.
+    std::vector<cv::Point> simplify(const std::vector<cv::Point>& contour, cvutil::LineSimplificationType type, double epsilon, bool isCircular);
+
+    // Finds the contours of input (with RETR_TREE), simplifies them on
+    // at most nthreads workers of the pool (all of them if nthreads <= 0)
+    // and removes the deleted contours from the lists.
+    void linesim_contours(cv::Mat input, std::vector<std::vector<cv::Point>>& contours, std::vector<cv::Vec4i>& hierarchy,
+        cvutil::LineSimplificationType type, double epsilon, int nthreads = 0);
+
+    // Draws the filled simplified contours of input into result, which
+    // is only reallocated if it is not a CV_8UC1 image of the same size.
+    void linesim_mt(cv::Mat input, cv::Mat& result, cvutil::LineSimplificationType type, double epsilon, int nthreads = 0);
     //Mat linesim_mt_pthread(Mat inputc, Mat subs, Mat inds);
 }
 
@@ -27,8 +27,16 @@ along with cvutil; see the file COPYING.  If not, see
 */
 
 #include "cvutil.h"
+#include "cvutil_avx512.h"
 #include "cvutil_matlab_interface.h"
 #include "cvutil_bwdist.h"
+#include "cvutil_threadpool.h"
+
+#include <bitset>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #pragma warning(disable : 4752)
 
@@ -82,6 +90,16 @@ namespace FloorCeilFunctions
         int i = 0, k = 0;
         int stepsize = 8, counter_end = nelements;
 
+#if defined(CVUTIL_AVX512)
+        if (checkHardwareSupport(CPU_AVX_512F))
+        {
+            i = avx512_helper::floor_ps(data, counter_end);
+
+            for (; i < counter_end; i++)
+                data[i] = floor(data[i]);
+        }
+        else
+#endif
         if (checkHardwareSupport(CPU_AVX2))
         {
             // Check for memory alignment before performing vector operations.
@@ -128,6 +146,16 @@ namespace FloorCeilFunctions
         int i = 0, k = 0;
         int stepsize = 4, counter_end = nelements;
 
+#if defined(CVUTIL_AVX512)
+        if (checkHardwareSupport(CPU_AVX_512F))
+        {
+            i = avx512_helper::floor_pd(data, counter_end);
+
+            for (; i < counter_end; i++)
+                data[i] = floor(data[i]);
+        }
+        else
+#endif
         if (checkHardwareSupport(CPU_AVX2))
         {
             // Check for memory alignment before performing vector operations.
@@ -174,6 +202,16 @@ namespace FloorCeilFunctions
         int i = 0, k = 0;
         int stepsize = 8, counter_end = nelements;
 
+#if defined(CVUTIL_AVX512)
+        if (checkHardwareSupport(CPU_AVX_512F))
+        {
+            i = avx512_helper::ceil_ps(data, counter_end);
+
+            for (; i < counter_end; i++)
+                data[i] = ceil(data[i]);
+        }
+        else
+#endif
         if (checkHardwareSupport(CPU_AVX2))
         {
             // Check for memory alignment before performing vector operations.
@@ -220,6 +258,16 @@ namespace FloorCeilFunctions
         int i = 0, k = 0;
         int stepsize = 4, counter_end = nelements;
 
+#if defined(CVUTIL_AVX512)
+        if (checkHardwareSupport(CPU_AVX_512F))
+        {
+            i = avx512_helper::ceil_pd(data, counter_end);
+
+            for (; i < counter_end; i++)
+                data[i] = ceil(data[i]);
+        }
+        else
+#endif
         if (checkHardwareSupport(CPU_AVX2))
         {
             // Check for memory alignment before performing vector operations.
@@ -385,11 +433,230 @@ namespace FindHelper
 {
     namespace internal
     {
+        // Non-zero mask of the 32 elements starting at inpptr, with bit
+        // k set if the k-th element is non-zero.
+        inline uint32_t nonzero_mask32(const uchar* inpptr)
+        {
+            __m256i buffer = _mm256_loadu_si256((const __m256i *)inpptr);
+            return ~uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(buffer, _mm256_setzero_si256())));
+        }
+
+        inline uint32_t nonzero_mask32(const char* inpptr)
+        {
+            return nonzero_mask32(reinterpret_cast<const uchar *>(inpptr));
+        }
+
+        // The 16-bit comparisons are packed to bytes. The packing works
+        // within 128-bit lanes, so the 64-bit blocks are reordered
+        // before taking the byte mask.
+        inline uint32_t nonzero_mask32(const ushort* inpptr)
+        {
+            __m256i zero = _mm256_setzero_si256();
+            __m256i lo = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)inpptr), zero);
+            __m256i hi = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)(inpptr + 16)), zero);
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+
+            return ~uint32_t(_mm256_movemask_epi8(packed));
+        }
+
+        inline uint32_t nonzero_mask32(const short* inpptr)
+        {
+            return nonzero_mask32(reinterpret_cast<const ushort *>(inpptr));
+        }
+
+        inline uint32_t nonzero_mask32(const int* inpptr)
+        {
+            uint32_t mask = 0;
+
+            for (int k = 0; k < 4; k++)
+            {
+                __m256i buffer = _mm256_loadu_si256((const __m256i *)(inpptr + 8 * k));
+                __m256i iszero = _mm256_cmpeq_epi32(buffer, _mm256_setzero_si256());
+                mask |= uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(iszero))) << (8 * k);
+            }
+
+            return ~mask;
+        }
+
+        // Floating point values are compared against zero, so that -0.0
+        // is treated as zero and NaN as non-zero (as in the scalar code).
+        inline uint32_t nonzero_mask32(const float* inpptr)
+        {
+            uint32_t mask = 0;
+
+            for (int k = 0; k < 4; k++)
+            {
+                __m256 nonzero = _mm256_cmp_ps(_mm256_loadu_ps(inpptr + 8 * k), _mm256_setzero_ps(), _CMP_NEQ_UQ);
+                mask |= uint32_t(_mm256_movemask_ps(nonzero)) << (8 * k);
+            }
+
+            return mask;
+        }
+
+        inline uint32_t nonzero_mask32(const double* inpptr)
+        {
+            uint32_t mask = 0;
+
+            for (int k = 0; k < 8; k++)
+            {
+                __m256d nonzero = _mm256_cmp_pd(_mm256_loadu_pd(inpptr + 4 * k), _mm256_setzero_pd(), _CMP_NEQ_UQ);
+                mask |= uint32_t(_mm256_movemask_pd(nonzero)) << (4 * k);
+            }
+
+            return mask;
+        }
+
+        inline int popcount32(uint32_t mask)
+        {
+            return int(bitset<32>(mask).count());
+        }
+
+        // For every 8-bit mask, the positions of its set bits in
+        // increasing order, followed by zeros. Adding the index of the
+        // first of 8 elements to the row of their mask gives the packed
+        // indices of the non-zero elements.
+        struct CompressTable
+        {
+            alignas(32) int positions[256][8];
+
+            CompressTable()
+            {
+                for (int m = 0; m < 256; m++)
+                {
+                    int n = 0;
+
+                    for (int k = 0; k < 8; k++)
+                        if (m & (1 << k))
+                            positions[m][n++] = k;
+
+                    for (; n < 8; n++)
+                        positions[m][n] = 0;
+                }
+            }
+        };
+
+        inline const CompressTable& compress_table()
+        {
+            static const CompressTable table;
+            return table;
+        }
+
+        // Forward find of the linear indices, 32 elements at a time.
+        // Each group of 8 elements is packed with a full width store, so
+        // the vector loop stops while the output has room for 8 more
+        // indices after the current block.
+        template<typename T>
+        inline void find_indices_avx2(T* inpptr, int* indsubptr, int nelements, int nNonZeros)
+        {
+            const T zero = static_cast<T>(0);
+            const CompressTable& table = compress_table();
+            uint32_t mask, m;
+            int i = 0, j = 0, k;
+
+            for (; (i + 32) <= nelements; i += 32)
+            {
+                mask = nonzero_mask32(&inpptr[i]);
+
+                if (mask == 0)
+                    continue;
+
+                if ((j + popcount32(mask) + 8) > nNonZeros)
+                    break;
+
+                for (k = 0; k < 32; k += 8)
+                {
+                    m = (mask >> k) & 0xFF;
+
+                    __m256i pos = _mm256_load_si256((const __m256i *)table.positions[m]);
+                    _mm256_storeu_si256((__m256i *)&indsubptr[j], _mm256_add_epi32(pos, _mm256_set1_epi32(i + k)));
+                    j += popcount32(m);
+                }
+            }
+
+            for (; (i < nelements && j < nNonZeros); i++)
+            {
+                if (inpptr[i] != zero)
+                {
+                    indsubptr[j] = i;
+                    j++;
+                }
+            }
+        }
+
+        // Forward find of the row and column subscripts of a single 
+        // channel matrix, 32 columns at a time. The packed columns are
+        // interleaved with the row to write 8 (row, column) pairs with
+        // two full width stores.
+        template<typename T>
+        inline void find_subscripts_avx2(T* inpptr, int* indsubptr, int nelements, int nNonZeros, int ncols)
+        {
+            const T zero = static_cast<T>(0);
+            const CompressTable& table = compress_table();
+            int nrows = nelements / ncols;
+            uint32_t mask, m;
+            int r, c, k, j = 0;
+
+            for (r = 0; (r < nrows && j < nNonZeros); r++)
+            {
+                T *rowptr = inpptr + r * ncols;
+                __m256i vrow = _mm256_set1_epi32(r);
+
+                for (c = 0; (c + 32) <= ncols; c += 32)
+                {
+                    mask = nonzero_mask32(&rowptr[c]);
+
+                    if (mask == 0)
+                        continue;
+
+                    if ((j + popcount32(mask) + 8) > nNonZeros)
+                        break;
+
+                    for (k = 0; k < 32; k += 8)
+                    {
+                        m = (mask >> k) & 0xFF;
+
+                        __m256i pos = _mm256_load_si256((const __m256i *)table.positions[m]);
+                        __m256i cols = _mm256_add_epi32(pos, _mm256_set1_epi32(c + k));
+                        __m256i lo = _mm256_unpacklo_epi32(vrow, cols);
+                        __m256i hi = _mm256_unpackhi_epi32(vrow, cols);
+
+                        _mm256_storeu_si256((__m256i *)&indsubptr[j * 2], _mm256_permute2x128_si256(lo, hi, 0x20));
+                        _mm256_storeu_si256((__m256i *)&indsubptr[j * 2 + 8], _mm256_permute2x128_si256(lo, hi, 0x31));
+                        j += popcount32(m);
+                    }
+                }
+
+                for (; (c < ncols && j < nNonZeros); c++)
+                {
+                    if (rowptr[c] != zero)
+                    {
+                        indsubptr[j * 2] = r;
+                        indsubptr[j * 2 + 1] = c;
+                        j++;
+                    }
+                }
+            }
+        }
+
         template<typename T>
         inline void find_indices(T* inpptr, int* indsubptr, int nelements, int nNonZeros,  int forward)
         {
             const T zero = static_cast<T>(0);
 
+#if defined(CVUTIL_AVX512)
+            if (forward && checkHardwareSupport(CPU_AVX_512F))
+            {
+                avx512_helper::find_indices<T>(inpptr, indsubptr, nelements, nNonZeros);
+                return;
+            }
+#endif
+
+            if (forward && checkHardwareSupport(CPU_AVX2))
+            {
+                find_indices_avx2<T>(inpptr, indsubptr, nelements, nNonZeros);
+                return;
+            }
+
             if (forward)
             {
                 for (int i = 0, j = 0; (i < nelements && j < nNonZeros); i++)
@@ -454,6 +721,20 @@ namespace FindHelper
             if (nchannels > 1)
                 nOutputCols++;
 
+#if defined(CVUTIL_AVX512)
+            if (forward && nchannels == 1 && checkHardwareSupport(CPU_AVX_512F))
+            {
+                avx512_helper::find_subscripts<T>(inpptr, indsubptr, nelements, nNonZeros, ncols);
+                return;
+            }
+#endif
+
+            if (forward && nchannels == 1 && checkHardwareSupport(CPU_AVX2))
+            {
+                find_subscripts_avx2<T>(inpptr, indsubptr, nelements, nNonZeros, ncols);
+                return;
+            }
+
             if (forward)
             {
                 for (int i = 0, j = 0; (i < nelements && j < nNonZeros); i++)
@@ -712,6 +993,218 @@ namespace FindHelper
             break;
         }
     }
+
+    namespace internal
+    {
+        inline int lowest_set_bit(uint32_t mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long k;
+            _BitScanForward(&k, mask);
+            return int(k);
+#else
+            return __builtin_ctz(mask);
+#endif
+        }
+
+        // Column of the first element at or after c that is non-zero
+        // (or zero, if nonzero is false), or ncols if there is none.
+        template<typename T>
+        inline int find_next(const T* rowptr, int c, int ncols, bool nonzero, bool useavx)
+        {
+            const T zero = static_cast<T>(0);
+
+            if (useavx)
+            {
+                for (; (c + 32) <= ncols; c += 32)
+                {
+                    uint32_t mask = nonzero_mask32(&rowptr[c]);
+
+                    if (!nonzero)
+                        mask = ~mask;
+
+                    if (mask)
+                        return c + lowest_set_bit(mask);
+                }
+            }
+
+            for (; c < ncols; c++)
+                if ((rowptr[c] != zero) == nonzero)
+                    return c;
+
+            return ncols;
+        }
+
+        // Appends the (row, first column, length) of the runs of the
+        // rows [rstart, rend) to runs.
+        template<typename T>
+        inline void find_runs(Mat input, int rstart, int rend, vector<int>& runs)
+        {
+            bool useavx = checkHardwareSupport(CPU_AVX2);
+            int ncols = input.cols;
+
+            for (int r = rstart; r < rend; r++)
+            {
+                const T *rowptr = input.ptr<T>(r);
+                int c = 0, cend;
+
+                while ((c = find_next(rowptr, c, ncols, true, useavx)) < ncols)
+                {
+                    cend = find_next(rowptr, c, ncols, false, useavx);
+
+                    runs.push_back(r);
+                    runs.push_back(c);
+                    runs.push_back(cend - c);
+                    c = cend;
+                }
+            }
+        }
+    }
+
+    inline void find_runs(Mat input, int rstart, int rend, vector<int>& runs)
+    {
+        switch (input.depth())
+        {
+        case CV_8U:
+            internal::find_runs<uchar>(input, rstart, rend, runs);
+            break;
+        case CV_8S:
+            internal::find_runs<char>(input, rstart, rend, runs);
+            break;
+        case CV_16U:
+            internal::find_runs<ushort>(input, rstart, rend, runs);
+            break;
+        case CV_16S:
+            internal::find_runs<short>(input, rstart, rend, runs);
+            break;
+        case CV_32S:
+            internal::find_runs<int>(input, rstart, rend, runs);
+            break;
+        case CV_32F:
+            internal::find_runs<float>(input, rstart, rend, runs);
+            break;
+        case CV_64F:
+            internal::find_runs<double>(input, rstart, rend, runs);
+            break;
+        }
+    }
+
+    // Each worker collects the runs of its band of rows, and the bands
+    // are then concatenated in order.
+    inline Mat find_runs(Mat input)
+    {
+        Mat runs;
+        vector<vector<int>> bandruns;
+        vector<int> offsets;
+
+        threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
+        {
+            if (tid == 0)
+                bandruns.resize(nthreads);
+
+            barrier.wait();
+
+            int rstart = tid * input.rows / nthreads;
+            int rend = (tid == (nthreads - 1)) ? input.rows : ((tid + 1) * input.rows / nthreads);
+
+            find_runs(input, rstart, rend, bandruns[tid]);
+            barrier.wait();
+
+            if (tid == 0)
+            {
+                offsets.assign(nthreads + 1, 0);
+
+                for (int t = 0; t < nthreads; t++)
+                    offsets[t + 1] = offsets[t] + static_cast<int>(bandruns[t].size());
+
+                if (offsets[nthreads] > 0)
+                    runs.create(offsets[nthreads] / 3, 3, CV_32SC1);
+            }
+
+            barrier.wait();
+
+            if (!bandruns[tid].empty())
+                copy(bandruns[tid].begin(), bandruns[tid].end(), runs.ptr<int>() + offsets[tid]);
+        });
+
+        return runs;
+    }
+
+    // Images with fewer elements are searched on the calling thread.
+    const int FIND_MT_MIN_ELEMENTS = 1 << 18;
+
+    // Multithreaded forward find of the first n (all if n <= 0)
+    // indices or subscripts. Each worker counts the non-zero elements
+    // of its band of rows, and after a prefix sum of the counts writes
+    // the indices/subscripts of its band at its offset in the output.
+    // Returns an empty matrix if there are no non-zero elements.
+    inline Mat find_mt(Mat input, cvutil::FindType type, int n)
+    {
+        Mat indsub;
+        vector<int> offsets;
+        int nOutputCols = (type == cvutil::FindType::Indices) ? 1 : ((input.channels() > 1) ? 3 : 2);
+        int nrowelements = input.cols * input.channels();
+
+        threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
+        {
+            if (tid == 0)
+                offsets.assign(nthreads + 1, 0);
+
+            barrier.wait();
+
+            int rstart = tid * input.rows / nthreads;
+            int rend = (tid == (nthreads - 1)) ? input.rows : ((tid + 1) * input.rows / nthreads);
+            Mat band = input.rowRange(rstart, rend);
+
+            if (rend > rstart)
+                offsets[tid + 1] = countNonZero(band.reshape(1, band.rows));
+
+            barrier.wait();
+
+            if (tid == 0)
+            {
+                for (int t = 0; t < nthreads; t++)
+                    offsets[t + 1] += offsets[t];
+
+                int N = offsets[nthreads];
+
+                if (n > 0 && N > n)
+                    N = n;
+
+                if (N > 0)
+                    indsub.create(N, nOutputCols, CV_32SC1);
+            }
+
+            barrier.wait();
+
+            int first = offsets[tid], last = min(offsets[tid + 1], indsub.rows);
+
+            if (first >= last)
+                return;
+
+            Mat out = indsub.rowRange(first, last);
+            int *outptr = out.ptr<int>();
+
+            // The band is searched as an image of its own, so the
+            // results are shifted to the position of the band.
+            if (type == cvutil::FindType::Indices)
+            {
+                find_indices(band, out, 1);
+
+                for (int k = 0; k < out.rows; k++)
+                    outptr[k] += rstart * nrowelements;
+            }
+            else
+            {
+                find_subscripts(band, out, 1);
+
+                for (int k = 0; k < out.rows; k++)
+                    outptr[k * nOutputCols] += rstart;
+            }
+        });
+
+        return indsub;
+    }
 }
 
 pair<Mat, Mat> cvutil::find(Mat input, FindType type, int n, const string& direction)
@@ -723,6 +1216,34 @@ pair<Mat, Mat> cvutil::find(Mat input, FindType type, int n, const string& direc
     Mat sinput;
     int N, nOutputCols, forward = -1;
 
+    if (type == FindType::Runs)
+    {
+        CV_ASSERT2(nchannels == 1, "x must be a single channel matrix to find the runs.");
+        return pair<Mat, Mat>(FindHelper::find_runs(input), Mat());
+    }
+
+    // set configuration based on the arguments.
+    if (n > 0)
+    {
+        CV_ASSERT2((direction == "first" || direction == "last"), "direction must be either \"first\" or \"last\".");
+
+        if (direction == "first")
+            forward = 1;
+        else
+            forward = 0;
+    }
+    else
+        forward = 1;
+
+    // Large forward searches of indices or subscripts count and write
+    // the non-zero elements in parallel bands.
+    if (forward && (type == FindType::Indices || type == FindType::Subscripts) &&
+        input.total() * nchannels >= size_t(FindHelper::FIND_MT_MIN_ELEMENTS) && input.isContinuous())
+    {
+        Mat indsub = FindHelper::find_mt(input, type, n);
+        return pair<Mat, Mat>(indsub, Mat());
+    }
+
     // The countNonZero offered by OpenCV is hardware accelerated. 
     // Hence, it is better to use this function than reimplementing
     // it. But this function takes Mat objects having single channel.
@@ -736,23 +1257,10 @@ pair<Mat, Mat> cvutil::find(Mat input, FindType type, int n, const string& direc
     // Now to call the countNonZero()
     N = countNonZero(sinput);
 
-    // set configuration based on the arguments.
     if (N == 0)
         return pair<Mat, Mat>(Mat(), Mat());
-    else if (n > 0)
-    {
-        CV_ASSERT2((direction == "first" || direction == "last"), "direction must be either \"first\" or \"last\".");
-
-        if (direction == "first")
-            forward = 1;
-        else
-            forward = 0;
-
-        if (N >= n)
-            N = n;
-    }
-    else
-        forward = 1;
+    else if (n > 0 && N >= n)
+        N = n;
     
     switch (type)
     {
@@ -827,10 +1335,12 @@ Mat cvutil::bwdist(Mat input)
 
     Mat out;
 
+    // bwdist_mt() further selects the AVX-512 kernels at runtime, if
+    // they are built (ENABLE_AVX512) and the CPU supports them.
     if(checkHardwareSupport(CPU_AVX2))
         out = bwdist_helper::bwdist_mt(input.clone());
     else
-        out = bwdist_helper::bwdist_st_no_avx(input.clone());
+        out = bwdist_helper::bwdist_mt_no_avx(input.clone());
 
     //Mat result = out.rowRange(1, inputc.rows - 1).colRange(1, inputc.cols - 1);
     return out;
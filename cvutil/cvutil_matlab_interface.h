@@ -38,7 +38,7 @@ along with cvutil; see the file COPYING.  If not, see
 
 namespace cvutil
 {
-    enum class FindType { Indices, IndicesAndValues, Subscripts, SubscriptsAndValues };
+    enum class FindType { Indices, IndicesAndValues, Subscripts, SubscriptsAndValues, Runs };
 
     // MATLAB interface to im2double()
     CVUTILAPI cv::Mat im2double(cv::Mat input);
@@ -149,6 +149,12 @@ namespace cvutil
     //                           and channels in that order, as well as 
     //                           the last column containing the value of 
     //                           the element at that location.
+    //     Runs                - Returns a three column matrix, containing
+    //                           the row, the first column and the length
+    //                           of the maximal horizontal runs of non-zero
+    //                           elements, in raster order. x must be a
+    //                           single channel matrix, and n and 
+    //                           direction are ignored.
     // n         - n is the number of first/last indices/subscripts that
     //             needs to be returned. If n is negative, it returns all 
     //             the subscripts/indices that are non-zero.
@@ -0,0 +1,140 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_rowruns.h
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef CVUTIL_ROWRUNS_H
+#define CVUTIL_ROWRUNS_H
+
+#include "stdproto.h"
+
+namespace rowruns_helper
+{
+    // Foreground pixels of an image stored as maximal horizontal runs,
+    // in raster order. The runs of row r are the runs in the range
+    // [rowoffsets[r], rowoffsets[r + 1]), and pixel k of run j is at
+    // position offsets[j] + k, so that the state of the foreground
+    // pixels can be kept in a compact per-pixel array.
+    class RunList
+    {
+    public:
+        int rows = 0, cols = 0;
+        std::vector<int> rowoffsets;    // rows + 1 elements
+        std::vector<int> starts;        // First column of each run
+        std::vector<int> ends;          // Last column of each run
+        std::vector<int> offsets;       // count() + 1 elements
+
+        RunList() {}
+
+        // runs is a 3 column CV_32SC1 matrix of (row, first column,
+        // length) in raster order, as given by cvutil::find() with
+        // FindType::Runs.
+        RunList(cv::Mat runs, int nrows, int ncols) { create(runs, nrows, ncols); }
+
+        void create(cv::Mat runs, int nrows, int ncols)
+        {
+            int nruns = runs.empty() ? 0 : runs.rows;
+            const int *runptr = nruns ? runs.ptr<int>() : nullptr;
+
+            rows = nrows;
+            cols = ncols;
+            rowoffsets.assign(rows + 1, 0);
+            starts.resize(nruns);
+            ends.resize(nruns);
+            offsets.resize(nruns + 1);
+            offsets[0] = 0;
+
+            for (int j = 0; j < nruns; j++)
+            {
+                starts[j] = runptr[3 * j + 1];
+                ends[j] = runptr[3 * j + 1] + runptr[3 * j + 2] - 1;
+                offsets[j + 1] = offsets[j] + runptr[3 * j + 2];
+                rowoffsets[runptr[3 * j] + 1]++;
+            }
+
+            for (int r = 0; r < rows; r++)
+                rowoffsets[r + 1] += rowoffsets[r];
+        }
+
+        int count() const { return static_cast<int>(starts.size()); }
+        int pixels() const { return offsets.back(); }
+    };
+
+    // Cursor over the runs of one row, for lookups at non-decreasing
+    // columns. The cursor only moves forward, so looking up all the
+    // pixels of a row in an adjacent row is linear in the number of
+    // runs of both rows.
+    class RunCursor
+    {
+        const RunList& list;
+        int run, last;
+
+        int position(int j, int c) const
+        {
+            return (j < last && list.starts[j] <= c && c <= list.ends[j]) ? list.offsets[j] + c - list.starts[j] : -1;
+        }
+
+    public:
+        // Rows outside the image have no runs.
+        RunCursor(const RunList& runs, int row) : list(runs)
+        {
+            bool inside = (row >= 0 && row < runs.rows);
+
+            run = inside ? runs.rowoffsets[row] : 0;
+            last = inside ? runs.rowoffsets[row + 1] : 0;
+        }
+
+        // Position of the pixel at column c, or -1 if it is not in a run.
+        int find(int c)
+        {
+            while (run < last && list.ends[run] < c)
+                run++;
+
+            return position(run, c);
+        }
+
+        // Positions of the pixels at columns c - 1, c and c + 1 (-1 for
+        // the ones that are not in a run). The three pixels span at most
+        // two runs, since runs are separated by at least one pixel.
+        void find3(int c, int pos[3])
+        {
+            while (run < last && list.ends[run] < c - 1)
+                run++;
+
+            for (int k = 0; k < 3; k++)
+            {
+                pos[k] = position(run, c - 1 + k);
+
+                if (pos[k] == -1)
+                    pos[k] = position(run + 1, c - 1 + k);
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,320 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_skelgraph.cpp
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+// Skeleton graph extraction
+//
+// The skeleton is labeled into 8-connected components, and the
+// components are split between the workers in contiguous ranges of
+// about the same number of pixels. Each worker marks the pixels of its
+// components that do not have exactly two neighbors as nodes, and then
+// walks from every node along the chains of two-neighbor pixels until
+// the next node, so that each pixel is visited a constant number of
+// times. The label image is reused to hold the local node index (or
+// the visited state) of every skeleton pixel, which is safe since the
+// walks never leave their component. The partial graphs are finally
+// concatenated in the order of the components.
+
+#include "cvutil_skelgraph.h"
+#include "cvutil_conncomp.h"
+#include "cvutil_threadpool.h"
+
+using namespace std;
+using namespace cv;
+
+namespace
+{
+    const int UNVISITED = -1;
+    const int VISITED = -2;
+
+    // Offsets of the 8-neighbors, in the order of the bwthin() tables.
+    const int drow[8] = { 0, -1, -1, -1, 0, 1, 1, 1 };
+    const int dcol[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+
+    // Writes the 1-D indices of the skeleton neighbors of pixel p to nb
+    // and returns their number.
+    inline int skel_neighbors(const uchar *skel, int rows, int cols, int p, int nb[8])
+    {
+        int r = p / cols, c = p - r * cols, n = 0;
+
+        for (int k = 0; k < 8; k++)
+        {
+            int rr = r + drow[k], cc = c + dcol[k];
+
+            if (rr < 0 || rr >= rows || cc < 0 || cc >= cols)
+                continue;
+
+            int q = rr * cols + cc;
+
+            if (skel[q])
+                nb[n++] = q;
+        }
+
+        return n;
+    }
+
+    // Graph of a range of components. The node indices are local to
+    // the part, and edgeoffsets starts at 0.
+    struct graph_part
+    {
+        vector<int> nodes, nodecomps;
+        vector<int> edges, edgeoffsets, edgepixels;
+        vector<double> lengths, radii;
+    };
+
+    struct graph_tracer
+    {
+        const uchar *skel;
+        const float *dist;
+        int *nodeid;
+        int rows, cols;
+        graph_part *part;
+
+        // Closes the edge from node a whose pixels start at
+        // part->edgepixels[start].
+        void add_edge(int a, int b, int start)
+        {
+            const int *run = part->edgepixels.data() + start;
+            int n = int(part->edgepixels.size()) - start;
+            double length = 0, radius = 0;
+
+            for (int i = 1; i < n; i++)
+            {
+                int dr = run[i] / cols - run[i - 1] / cols;
+                length += (dr != 0 && run[i] - run[i - 1] != dr * cols) ? CV_SQRT2 : 1.0;
+            }
+
+            if (dist != nullptr)
+            {
+                for (int i = 0; i < n; i++)
+                    radius += dist[run[i]];
+
+                radius /= n;
+            }
+
+            part->edges.push_back(a);
+            part->edges.push_back(b);
+            part->edgeoffsets.push_back(int(part->edgepixels.size()));
+            part->lengths.push_back(length);
+            part->radii.push_back(radius);
+        }
+
+        // Walks from node a at pixel pa through its neighbor q along the
+        // two-neighbor pixels until a node is reached.
+        void trace(int a, int pa, int q)
+        {
+            int start = int(part->edgepixels.size());
+            int prev = pa, cur = q;
+            int nb[8];
+
+            part->edgepixels.push_back(pa);
+
+            while (nodeid[cur] == UNVISITED)
+            {
+                nodeid[cur] = VISITED;
+                part->edgepixels.push_back(cur);
+
+                skel_neighbors(skel, rows, cols, cur, nb);
+
+                int next = (nb[0] == prev) ? nb[1] : nb[0];
+                prev = cur;
+                cur = next;
+            }
+
+            part->edgepixels.push_back(cur);
+            add_edge(a, nodeid[cur], start);
+        }
+
+        void process(int comp, const int *pbegin, const int *pend)
+        {
+            int nb[8];
+            int nfirst = int(part->nodes.size());
+
+            for (const int *p = pbegin; p != pend; p++)
+            {
+                if (skel_neighbors(skel, rows, cols, *p, nb) == 2)
+                    nodeid[*p] = UNVISITED;
+                else
+                {
+                    nodeid[*p] = int(part->nodes.size());
+                    part->nodes.push_back(*p);
+                    part->nodecomps.push_back(comp);
+                }
+            }
+
+            int nlast = int(part->nodes.size());
+
+            for (int a = nfirst; a < nlast; a++)
+            {
+                int pa = part->nodes[a];
+                int n = skel_neighbors(skel, rows, cols, pa, nb);
+
+                for (int k = 0; k < n; k++)
+                {
+                    int b = nodeid[nb[k]];
+
+                    // Adjacent nodes are joined by an edge without
+                    // interior pixels, added once.
+                    if (b >= 0)
+                    {
+                        if (a < b)
+                        {
+                            int start = int(part->edgepixels.size());
+                            part->edgepixels.push_back(pa);
+                            part->edgepixels.push_back(nb[k]);
+                            add_edge(a, b, start);
+                        }
+                    }
+                    else if (b == UNVISITED)
+                        trace(a, pa, nb[k]);
+                }
+            }
+
+            // A component without nodes is a simple closed curve. Its
+            // first pixel is made a node with a loop edge.
+            if (nfirst == nlast)
+            {
+                int pa = *pbegin;
+                int a = int(part->nodes.size());
+
+                nodeid[pa] = a;
+                part->nodes.push_back(pa);
+                part->nodecomps.push_back(comp);
+
+                skel_neighbors(skel, rows, cols, pa, nb);
+                trace(a, pa, nb[0]);
+            }
+        }
+    };
+}
+
+void skelgraph_helper::build_graph(Mat skel, Mat dist, cvutil::SkeletonGraph& graph)
+{
+    cvutil::ComponentList comps;
+    Mat lab;
+
+    conncomp_helper::label_mt(skel, lab, -1, 8, comps, false);
+
+    int ncomps = comps.size();
+    long long npixels = comps.indices.size();
+    vector<graph_part> parts;
+    vector<int> nodebase, edgebase, pixelbase;
+
+    graph.imsize = skel.size();
+
+    threadpool_helper::parallel_run([&](int tid, int nthreads, threadpool_helper::Barrier& barrier)
+    {
+        if (tid == 0)
+            parts.resize(nthreads);
+
+        barrier.wait();
+
+        // Ranges of whole components with about the same number of
+        // pixels.
+        auto first_component = [&](int t) -> int
+        {
+            if (t == nthreads)
+                return ncomps;
+
+            int p = int(t * npixels / nthreads);
+            return int(lower_bound(comps.offsets.begin(), comps.offsets.begin() + ncomps, p) - comps.offsets.begin());
+        };
+
+        int cstart = first_component(tid);
+        int cend = first_component(tid + 1);
+
+        graph_part& part = parts[tid];
+        graph_tracer tracer = { skel.ptr<uchar>(), dist.empty() ? nullptr : dist.ptr<float>(),
+            lab.ptr<int>(), skel.rows, skel.cols, &part };
+
+        part.edgeoffsets.push_back(0);
+
+        for (int c = cstart; c < cend; c++)
+            tracer.process(c, comps.begin(c), comps.end(c));
+
+        barrier.wait();
+
+        if (tid == 0)
+        {
+            nodebase.assign(nthreads + 1, 0);
+            edgebase.assign(nthreads + 1, 0);
+            pixelbase.assign(nthreads + 1, 0);
+
+            for (int t = 0; t < nthreads; t++)
+            {
+                nodebase[t + 1] = nodebase[t] + int(parts[t].nodes.size());
+                edgebase[t + 1] = edgebase[t] + int(parts[t].lengths.size());
+                pixelbase[t + 1] = pixelbase[t] + int(parts[t].edgepixels.size());
+            }
+
+            graph.nodes.resize(nodebase[nthreads]);
+            graph.nodecomps.resize(nodebase[nthreads]);
+            graph.edges.resize(2 * edgebase[nthreads]);
+            graph.edgeoffsets.resize(edgebase[nthreads] + 1);
+            graph.edgepixels.resize(pixelbase[nthreads]);
+            graph.lengths.resize(edgebase[nthreads]);
+            graph.radii.resize(edgebase[nthreads]);
+            graph.edgeoffsets[edgebase[nthreads]] = pixelbase[nthreads];
+        }
+
+        barrier.wait();
+
+        int nbase = nodebase[tid], ebase = edgebase[tid], pbase = pixelbase[tid];
+        int nedges = int(part.lengths.size());
+
+        copy(part.nodes.begin(), part.nodes.end(), graph.nodes.begin() + nbase);
+        copy(part.nodecomps.begin(), part.nodecomps.end(), graph.nodecomps.begin() + nbase);
+        copy(part.edgepixels.begin(), part.edgepixels.end(), graph.edgepixels.begin() + pbase);
+        copy(part.lengths.begin(), part.lengths.end(), graph.lengths.begin() + ebase);
+        copy(part.radii.begin(), part.radii.end(), graph.radii.begin() + ebase);
+
+        for (int i = 0; i < nedges; i++)
+        {
+            graph.edges[2 * (ebase + i)] = part.edges[2 * i] + nbase;
+            graph.edges[2 * (ebase + i) + 1] = part.edges[2 * i + 1] + nbase;
+            graph.edgeoffsets[ebase + i] = part.edgeoffsets[i] + pbase;
+        }
+    });
+
+    // Adjacency of the nodes, with the incident edges of each node in
+    // increasing order. A loop is listed twice.
+    int nnodes = int(graph.nodes.size()), nedges = graph.edgecount();
+
+    graph.adjoffsets.assign(nnodes + 1, 0);
+    graph.adjedges.resize(2 * nedges);
+
+    for (int i = 0; i < 2 * nedges; i++)
+        graph.adjoffsets[graph.edges[i] + 1]++;
+
+    for (int i = 0; i < nnodes; i++)
+        graph.adjoffsets[i + 1] += graph.adjoffsets[i];
+
+    vector<int> cursor(graph.adjoffsets.begin(), graph.adjoffsets.end() - 1);
+
+    for (int i = 0; i < 2 * nedges; i++)
+        graph.adjedges[cursor[graph.edges[i]]++] = i / 2;
+}
@@ -0,0 +1,46 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_skelgraph.h
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef CVUTIL_SKELGRAPH_H
+#define CVUTIL_SKELGRAPH_H
+
+#include "cvutil.h"
+
+namespace skelgraph_helper
+{
+    // Builds the graph of the 8-connected skeleton skel (continuous
+    // CV_8UC1). dist is an optional continuous CV_32FC1 distance map of
+    // the same size used for the radii of the edges. The components of
+    // the skeleton are traced in parallel, and the partial graphs are
+    // concatenated in the raster order of the components.
+    void build_graph(cv::Mat skel, cv::Mat dist, cvutil::SkeletonGraph& graph);
+}
+
+#endif
@@ -0,0 +1,349 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_threadpool.cpp
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+// Persistent worker pool shared by the multithreaded kernels
+// (bwdist, bwthin, ...). Creating and joining std::threads on every
+// call costs more than the actual work on small images, so the
+// workers are spawned once and woken up for each task.
+
+#include "cvutil_threadpool.h"
+
+#include "cvutil.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+using namespace threadpool_helper;
+
+thread_local bool ThreadPool::insidepool = false;
+
+void Barrier::wait()
+{
+    unique_lock<mutex> lock(mtx);
+    unsigned long long gen = generation;
+
+    if (aborted)
+        throw Aborted();
+
+    if (++waiting == count)
+    {
+        waiting = 0;
+        generation++;
+        cv.notify_all();
+    }
+    else
+    {
+        cv.wait(lock, [&]() { return aborted || gen != generation; });
+
+        if (gen == generation)
+            throw Aborted();
+    }
+}
+
+void Barrier::abort()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        aborted = true;
+    }
+
+    cv.notify_all();
+}
+
+// Logical CPUs the process is allowed to run on, in increasing order.
+// The affinity mask of the process reflects the restrictions of
+// containers and cluster schedulers (cpusets, cgroups, taskset).
+static vector<int> allowed_cpus()
+{
+    vector<int> cpus;
+
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD_PTR procmask = 0, sysmask = 0;
+
+    if (GetProcessAffinityMask(GetCurrentProcess(), &procmask, &sysmask))
+        for (int cpu = 0; cpu < int(sizeof(DWORD_PTR) * 8); cpu++)
+            if (procmask & (DWORD_PTR(1) << cpu))
+                cpus.push_back(cpu);
+#elif defined(__linux__)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) == 0)
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &cpuset))
+                cpus.push_back(cpu);
+#endif
+
+    return cpus;
+}
+
+// Binds the thread to the k-th CPU the process is allowed to run on, so
+// that the workers of a process restricted to a subset of the CPUs stay
+// within it. Failure is not an error, in which case the OS placement is
+// kept.
+static void pin_thread(thread& t, int k)
+{
+    static const vector<int> cpus = allowed_cpus();
+
+    if (cpus.empty())
+        return;
+
+    int cpu = cpus[k % int(cpus.size())];
+
+#if defined(_WIN32) || defined(_WIN64)
+    SetThreadAffinityMask(static_cast<HANDLE>(t.native_handle()), DWORD_PTR(1) << cpu);
+#elif defined(__linux__)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    pthread_setaffinity_np(t.native_handle(), sizeof(cpu_set_t), &cpuset);
+#else
+    (void)t;
+#endif
+}
+
+ThreadPool::ThreadPool()
+{
+    int nthreads = 0;
+    bool pin = false;
+
+    // Allow the pool to be sized from the environment, so batch jobs
+    // sharing a cluster node can be limited without recompiling. The
+    // workers are not pinned by default, as several processes pinning
+    // their workers would compete for the same CPUs.
+    const char *envthreads = getenv("CVUTIL_NUM_THREADS");
+    const char *envpin = getenv("CVUTIL_PIN_THREADS");
+
+    if (envthreads != nullptr)
+        nthreads = atoi(envthreads);
+    if (envpin != nullptr)
+        pin = (atoi(envpin) != 0);
+
+    start(nthreads, pin);
+}
+
+ThreadPool::~ThreadPool()
+{
+    shutdown();
+}
+
+void ThreadPool::start(int nthreads, bool pin)
+{
+    if (nthreads <= 0)
+        nthreads = cv::getNumberOfCPUs();
+
+    stopping = false;
+    pinned = pin;
+    poolsize = nthreads;
+    workers.reserve(nthreads - 1);
+
+    // Worker 0 is the thread calling run(), so we only need
+    // nthreads - 1 threads in the pool.
+    for (int tid = 1; tid < nthreads; tid++)
+    {
+        workers.emplace_back(&ThreadPool::worker, this, tid, generation);
+
+        if (pinned)
+            pin_thread(workers.back(), tid);
+    }
+}
+
+void ThreadPool::shutdown()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+
+    startcv.notify_all();
+
+    for (auto &t : workers)
+        t.join();
+
+    workers.clear();
+}
+
+void ThreadPool::worker(int tid, unsigned long long seen)
+{
+    insidepool = true;
+
+    while (true)
+    {
+        const Task *func;
+        Barrier *phase;
+        int nthreads;
+
+        {
+            unique_lock<mutex> lock(mtx);
+            startcv.wait(lock, [&]() { return stopping || generation != seen; });
+
+            if (stopping)
+                return;
+
+            seen = generation;
+            func = task;
+            phase = barrier;
+            nthreads = taskthreads;
+        }
+
+        // An exception must not escape the worker thread. The first one
+        // is kept for run() to rethrow, and the barrier is aborted so
+        // that the other workers leave the task.
+        exception_ptr error;
+
+        try
+        {
+            (*func)(tid, nthreads, *phase);
+        }
+        catch (const Barrier::Aborted&)
+        {
+        }
+        catch (...)
+        {
+            error = current_exception();
+        }
+
+        if (error)
+            phase->abort();
+
+        {
+            lock_guard<mutex> lock(mtx);
+            if (error && !taskerror)
+                taskerror = error;
+            if (--pending == 0)
+                donecv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::resize(int nthreads, bool pin)
+{
+    // The pool cannot be rebuilt from one of its own tasks. The task's
+    // caller holds dispatchmtx and waits for all the workers.
+    CV_ASSERT2(!insidepool, "the number of workers cannot be changed from inside a parallel task.");
+
+    // Wait for the running task (if any) to complete.
+    lock_guard<mutex> dispatch(dispatchmtx);
+
+    shutdown();
+    start(nthreads, pin);
+}
+
+int ThreadPool::size()
+{
+    return poolsize;
+}
+
+void ThreadPool::run(const Task& func)
+{
+    unique_lock<mutex> dispatch(dispatchmtx, try_to_lock);
+
+    // Nested calls and calls made while another task owns the pool
+    // run serially on the calling thread.
+    if (insidepool || !dispatch.owns_lock() || workers.empty())
+    {
+        Barrier single(1);
+        func(0, 1, single);
+        return;
+    }
+
+    int nthreads = int(workers.size()) + 1;
+    Barrier phase(nthreads);
+
+    {
+        lock_guard<mutex> lock(mtx);
+        task = &func;
+        barrier = &phase;
+        taskthreads = nthreads;
+        pending = nthreads - 1;
+        generation++;
+    }
+
+    startcv.notify_all();
+
+    // The workers use func and phase until pending drops to zero, so
+    // the calling thread must wait for them even if its part throws.
+    {
+        struct InsidePool
+        {
+            InsidePool() { insidepool = true; }
+            ~InsidePool() { insidepool = false; }
+        } scope;
+
+        try
+        {
+            func(0, nthreads, phase);
+        }
+        catch (const Barrier::Aborted&)
+        {
+        }
+        catch (...)
+        {
+            {
+                lock_guard<mutex> lock(mtx);
+                if (!taskerror)
+                    taskerror = current_exception();
+            }
+
+            phase.abort();
+        }
+    }
+
+    exception_ptr error;
+
+    {
+        unique_lock<mutex> lock(mtx);
+        donecv.wait(lock, [&]() { return pending == 0; });
+        task = nullptr;
+        barrier = nullptr;
+
+        error = taskerror;
+        taskerror = nullptr;
+    }
+
+    if (error)
+        rethrow_exception(error);
+}
+
+void cvutil::setNumWorkers(int nthreads, bool pinned)
+{
+    ThreadPool::GetInstance()->resize(nthreads, pinned);
+}
+
+int cvutil::getNumWorkers()
+{
+    return ThreadPool::GetInstance()->size();
+}
@@ -0,0 +1,141 @@
+/*
+Copyright (C) 2025, Oak Ridge National Laboratory
+Copyright (C) 2021, Anand Seethepalli and Larry York
+Copyright (C) 2020, Courtesy of Noble Research Institute, LLC
+
+File: cvutil_threadpool.h
+
+Authors:
+Anand Seethepalli (seethepallia@ornl.gov)
+Larry York (yorklm@ornl.gov)
+
+This file is part of Computer Vision UTILity toolkit (cvutil)
+
+cvutil is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+cvutil is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with cvutil; see the file COPYING.  If not, see
+<https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef CVUTIL_THREADPOOL_H
+#define CVUTIL_THREADPOOL_H
+
+#include "stdproto.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace threadpool_helper
+{
+    // A reusable barrier for synchronizing the phases of a parallel
+    // kernel. All the nthreads workers of a task must call wait()
+    // before any of them proceeds to the next phase.
+    //
+    // If a worker throws, the barrier is aborted so that the other
+    // workers do not wait for it forever. wait() then throws
+    // Barrier::Aborted, which is consumed by the pool.
+    class Barrier
+    {
+        std::mutex mtx;
+        std::condition_variable cv;
+        int count;
+        int waiting = 0;
+        unsigned long long generation = 0;
+        bool aborted = false;
+
+    public:
+        struct Aborted {};
+
+        explicit Barrier(int n) : count(n) {}
+
+        void wait();
+        void abort();
+    };
+
+    // The task is invoked once per worker with the worker id (tid) in
+    // the range [0, nthreads). The kernel partitions its data using
+    // tid and nthreads, and uses the barrier to separate its phases.
+    typedef std::function<void(int tid, int nthreads, Barrier& barrier)> Task;
+
+    // Library-wide pool of worker threads. The pool is created on the
+    // first call to GetInstance(), so the threads are spawned once per
+    // process instead of once per kernel call. The calling thread always
+    // runs as worker 0, so a pool of size n owns n - 1 threads.
+    //
+    // Only one task runs on the pool at a time. If the pool is busy
+    // (for example, when several plugin instances call cvutil kernels
+    // concurrently) or if run() is called from inside a task, the task
+    // is executed on the calling thread with nthreads = 1.
+    class ThreadPool
+    {
+        ThreadPool();
+        ~ThreadPool();
+
+        void start(int nthreads, bool pin);
+        void shutdown();
+        void worker(int tid, unsigned long long seen);
+
+        std::vector<std::thread> workers;
+        std::mutex mtx, dispatchmtx;
+        std::condition_variable startcv, donecv;
+
+        const Task *task = nullptr;
+        Barrier *barrier = nullptr;
+        std::exception_ptr taskerror;
+        int taskthreads = 0;
+        int pending = 0;
+        std::atomic<int> poolsize{ 1 };
+        unsigned long long generation = 0;
+        bool stopping = false;
+        bool pinned = false;
+
+        static thread_local bool insidepool;
+
+    public:
+        static ThreadPool* GetInstance()
+        {
+            static ThreadPool instance;
+            return &instance;
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Rebuilds the pool with nthreads workers (including the calling
+        // thread). If nthreads <= 0, the number of logical CPUs is used.
+        // If pin is true, each worker is bound to a single logical CPU
+        // of the affinity mask of the process. Must not be called from
+        // inside a task, as it waits for the running task to complete.
+        void resize(int nthreads, bool pin);
+
+        // Number of workers a task gets when the pool is idle.
+        int size();
+
+        // Runs the task on all the workers and returns once every worker
+        // has returned from the task. If the task throws on any of the
+        // workers, the first exception is rethrown on the calling thread
+        // after all the workers have left the task.
+        void run(const Task& func);
+    };
+
+    inline void parallel_run(const Task& func)
+    {
+        ThreadPool::GetInstance()->run(func);
+    }
+}
+
+#endif
@@ -78,12 +78,10 @@ void extractfeatures(string filename)
     // To segment the image by thresholding...
     out = getSingleChannel(img < 0.79f, CV_8UC1);
     
-    vector<vector<int>> comps = getConnectedComponents(out, 500);
-    Mat matlist = getImageFromComponents(out.size(), comps);
+    Mat matlist = bwareaopen(out, 500);
     //Mat matlist = getLargestConnectedComponent(out);
     Mat lsim = linesim(matlist, LineSimplificationType::DouglasPeucker, 2.0);
-    comps = getConnectedComponents(lsim, 500);
-    lsim = getImageFromComponents(lsim.size(), comps);
+    lsim = bwareaopen(lsim, 500);
     toc("Time taken to perform line smoothing");
     
     tic();